@@ -4,40 +4,75 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
-// 【新增】接收光空间坐标（用于查阴影图）
-in vec4 FragPosLightSpace; 
+// 视空间深度（用于选择阴影级联）
+in float ViewDepth;
 
 // 纹理采样器
 uniform sampler2D texture_diffuse1;
-// 【新增】深度贴图（阴影图）
-uniform sampler2D shadowMap; 
+// 级联阴影图：每一层是一个级联 (近处的级联覆盖范围小、更清晰)
+#define MAX_CASCADES 4
+uniform sampler2DArray shadowMap;
+
+// 以下 uniform 块每帧由 FrameUniforms 写一次，所有程序共享 (成员顺序与 FrameUniforms.h 的结构体一致)
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
 // 动态太阳参数
-uniform vec3 lightPos;           // 太阳光的方向向量
-uniform vec3 lightColor;         // 太阳的实时颜色
-uniform float sunIntensity;    // 太阳的实时强度
-uniform float ambientStrength; // 实时环境光
-uniform vec3 viewPos;
+layout (std140) uniform Sun
+{
+    vec3 lightPos;           // 太阳的位置 (光线方向由它算出)
+    float sunIntensity;      // 太阳的实时强度
+    vec3 lightColor;         // 太阳的实时颜色
+    float ambientStrength;   // 实时环境光
+};
 
 // --- 【新增】路灯 (点光源) ---
 #define NR_POINT_LIGHTS 4  // 定义路灯数量：4盏
 struct PointLight {
     vec3 position;
-    vec3 color;
-    
     float constant;
+    vec3 color;
     float linear;
     float quadratic;
 };
-uniform PointLight pointLights[NR_POINT_LIGHTS]; // 数组
-uniform bool lampOn;     // 开关状态
+layout (std140) uniform Lamps
+{
+    PointLight pointLights[NR_POINT_LIGHTS]; // 数组
+    bool lampOn;     // 开关状态
+};
+
+layout (std140) uniform Shadow
+{
+    mat4 lightSpaceMatrices[MAX_CASCADES + 1]; // 最后一个是降雪遮挡高度图的投影 (这里用不到)
+    vec4 cascadeSplits;                // 每一级覆盖到的视空间深度
+    vec4 cascadeParams[MAX_CASCADES];  // x: 一个纹素的世界尺寸, y: 光空间深度范围
+    int cascadeCount;
+};
 
 // ==========================================================
 // 阴影计算函数
 // 返回值: 1.0 表示在阴影中(全黑)，0.0 表示不在阴影中(亮)
 // ==========================================================
-float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir)
+float ShadowCalculation(vec3 fragPos, vec3 normal, vec3 lightDir)
 {
+    // 0. 选择级联：第一个覆盖到当前深度的级联，超出最后一级就没有阴影
+    int cascade = -1;
+    for(int i = 0; i < cascadeCount; ++i)
+    {
+        if(ViewDepth < cascadeSplits[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+    if(cascade < 0)
+        return 0.0;
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(fragPos, 1.0);
+
     // 1. 执行透视除法 (将坐标变换到 [-1,1] 范围)
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     
@@ -52,19 +87,20 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir)
     float currentDepth = projCoords.z;
     
     // 5. 计算偏置 (Shadow Bias) - 非常重要！解决“阴影波纹(Acne)”
-    // 根据光线角度动态调整偏置量
-    float bias = max(0.005 * (1.0 - dot(normal, lightDir)), 0.0005);  
+    // 根据光线角度动态调整偏置量：以纹素的世界尺寸为单位，再换算到这一级的深度范围
+    float texelWorld = cascadeParams[cascade].x;
+    float bias = max(6.0 * (1.0 - dot(normal, lightDir)), 2.0) * texelWorld / cascadeParams[cascade].y;
 
     // 6. PCF (Percentage-Closer Filtering) 柔化阴影
     // 采样周围 9 个点取平均值，让阴影边缘不那么锯齿
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0); // 计算单个纹理像素的大小
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy); // 计算单个纹理像素的大小
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
             // 读取深度图上周围像素的深度值
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
+            float pcfDepth = texture(shadowMap, vec3(projCoords.xy + vec2(x, y) * texelSize, cascade)).r; 
             // 比较深度：如果当前深度 > 记录的深度，说明被挡住了
             shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;        
         }    
@@ -123,7 +159,7 @@ void main()
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
     vec3 specular = 0.2 * spec * lightColor; 
 
-    float shadow = ShadowCalculation(FragPosLightSpace, norm, sunLightDir);       
+    float shadow = ShadowCalculation(FragPos, norm, sunLightDir);       
     vec3 result = (ambient + (1.0 - shadow) * (diffuse + specular)) * objectColor;
 
     // =======================================================
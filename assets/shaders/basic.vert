@@ -2,29 +2,38 @@
 layout (location = 0) in vec3 aPos;      // 顶点位置
 layout (location = 1) in vec3 aNormal;   // 法线
 layout (location = 2) in vec2 aTexCoords;// 纹理坐标
+layout (location = 3) in mat4 aInstanceModel; // 实例化绘制时每个实例的模型矩阵 (占 3~6)
 
 out vec3 FragPos;   // 输出到片段着色器：世界坐标位置
 out vec3 Normal;    // 输出到片段着色器：法线
 out vec2 TexCoords; // 输出到片段着色器：纹理坐标
-out vec4 FragPosLightSpace; // 输出光空间坐标
+out float ViewDepth;  // 视空间深度 (选择阴影级联用)
 
 uniform mat4 model;      // 模型矩阵
-uniform mat4 view;       // 观察矩阵
-uniform mat4 projection; // 投影矩阵
-uniform mat4 lightSpaceMatrix; // 接收光矩阵
+uniform bool instanced;  // 为 true 时模型矩阵取实例属性，否则取 model
+
+// 每帧共享的相机数据 (FrameUniforms，绑定点 0)
+layout (std140) uniform Camera
+{
+    mat4 projection; // 投影矩阵
+    mat4 view;       // 观察矩阵
+    vec3 viewPos;
+};
 
 void main()
 {
+    mat4 modelMatrix = instanced ? aInstanceModel : model;
     // 计算顶点的世界坐标
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(modelMatrix * vec4(aPos, 1.0));
     // 计算法线（处理非均匀缩放）
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    Normal = mat3(transpose(inverse(modelMatrix))) * aNormal;  
     // 传递纹理坐标
     TexCoords = aTexCoords;
 
-    // 【新增】计算当前顶点在光空间的位置
-    FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
+    // 视空间深度：片段着色器按它选择阴影级联 (光空间坐标在片段着色器里按级联计算)
+    vec4 viewSpacePos = view * vec4(FragPos, 1.0);
+    ViewDepth = -viewSpacePos.z;
     
     // 最终的裁剪空间坐标
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    gl_Position = projection * viewSpacePos;
 }
\ No newline at end of file
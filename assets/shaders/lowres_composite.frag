@@ -0,0 +1,46 @@
+﻿#version 330 core
+// 低分辨率粒子合成：深度感知 (双边) 上采样
+// 在相邻的 4 个低分辨率像素之间做双线性插值，但权重再乘上与全分辨率场景深度的相似度，
+// 这样物体边缘处只会取用深度相近的样本，不会出现雪花"渗"到前景物体上的光晕
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D particleColor; // 低分辨率粒子结果 (预乘 alpha)
+uniform sampler2D lowDepth;      // 低分辨率场景深度
+uniform sampler2D sceneDepth;    // 全分辨率场景深度
+uniform vec2 lowTexelSize;
+uniform float nearPlane;
+uniform float farPlane;
+
+float linearDepth(float d)
+{
+    float z = d * 2.0 - 1.0;
+    return 2.0 * nearPlane * farPlane / (farPlane + nearPlane - z * (farPlane - nearPlane));
+}
+
+void main()
+{
+    float fullDepth = linearDepth(texture(sceneDepth, TexCoords).r);
+
+    vec2 lowPos = TexCoords / lowTexelSize - 0.5;
+    vec2 base = floor(lowPos);
+    vec2 f = lowPos - base;
+
+    vec4 color = vec4(0.0);
+    float weightSum = 0.0;
+    for (int j = 0; j < 2; ++j)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            vec2 uv = (base + vec2(i, j) + 0.5) * lowTexelSize;
+            float bilinear = (i == 0 ? 1.0 - f.x : f.x) * (j == 0 ? 1.0 - f.y : f.y);
+            float depthDiff = abs(linearDepth(texture(lowDepth, uv).r) - fullDepth) / fullDepth;
+            float weight = bilinear / (1e-3 + depthDiff);
+            color += texture(particleColor, uv) * weight;
+            weightSum += weight;
+        }
+    }
+
+    FragColor = weightSum > 0.0 ? color / weightSum : vec4(0.0);
+}
@@ -0,0 +1,20 @@
+﻿#version 330 core
+// 场景深度降采样：每个低分辨率像素取其覆盖的 downscale x downscale 个全分辨率像素中最近的深度
+// 取最近值保证细小的遮挡物 (栏杆、树枝) 在低分辨率下仍然能挡住后面的雪
+uniform sampler2D sceneDepth;
+uniform int downscale;
+
+void main()
+{
+    ivec2 base = ivec2(gl_FragCoord.xy) * downscale;
+    ivec2 maxCoord = textureSize(sceneDepth, 0) - 1;
+    float depth = 1.0;
+    for (int y = 0; y < downscale; ++y)
+    {
+        for (int x = 0; x < downscale; ++x)
+        {
+            depth = min(depth, texelFetch(sceneDepth, min(base + ivec2(x, y), maxCoord), 0).r);
+        }
+    }
+    gl_FragDepth = depth;
+}
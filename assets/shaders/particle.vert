@@ -1,15 +1,164 @@
 ﻿#version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
+// 实例化属性 (每个雪花一份)
+layout (location = 3) in vec4 aInstance; // xyz = 粒子位置, w = 粒子大小
+layout (location = 4) in float aAngle;   // 粒子在屏幕平面内的旋转角度
+// 无状态模式的实例属性：每个雪花只有生成时间偏移和随机种子，其余全部由时间解析计算
+layout (location = 5) in vec2 aStateless; // x = 生成时间偏移 (以周期为单位, 0~1), y = 随机种子
 
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// 与场景共享的相机数据 (FrameUniforms，绑定点 0)
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+uniform bool useInstancing; // true: 实例化路径; false: 旧的逐粒子 model 矩阵路径
+
+// 无状态模式
+uniform bool stateless;
+uniform float time;         // 进入无状态模式以来的时间
+uniform float cycleLength;  // 每个雪花的生成周期 (秒)，不小于最长寿命
+uniform float gravity;
+uniform float killHeight;
+uniform vec3 wind;
+uniform vec2 swayRate;      // 每秒摆动幅度 (x, z)
+uniform bool sway;          // 小雪时关闭摆动与旋转
+
+// 相机环绕体积：雪花绕回到以相机为中心的盒子里
+uniform bool wrap;
+uniform vec2 wrapCenter;     // 盒子水平中心 (x, z)
+uniform float wrapHalfExtent;
+uniform float wrapBottom;
+uniform float wrapHeight;
+
+// 降雪遮挡高度图 (PrecipitationOcclusion)：从正上方看的场景深度
+uniform bool occlusion;
+uniform sampler2D occlusionMap;
+uniform vec3 occlusionRect;  // x, z 方向的起点与 1 / 边长
+uniform vec2 occlusionRange; // 高度图的 bottom, top
+
+// 与 particle_update.vert 相同的整数哈希
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float randRange(inout uint state, float a, float b)
+{
+    state = hash(state);
+    return mix(a, b, float(state >> 8) * (1.0 / 16777216.0));
+}
+
+// 该位置第一个遮挡表面的高度 (正交投影深度是线性的；范围以外是边框深度 1，即 bottom)
+float surfaceHeight(vec2 xz)
+{
+    vec2 uv = (xz - occlusionRect.xy) * occlusionRect.z;
+    uv.y = 1.0 - uv.y; // 高度图的 v 方向对应世界 -z
+    float depth = textureLod(occlusionMap, uv, 0.0).r;
+    return mix(occlusionRange.y, occlusionRange.x, depth);
+}
+
+// 由时间直接算出雪花当前的位置/大小/角度，不在生命周期内时返回 false
+bool statelessFlake(out vec3 center, out float size, out float angle)
+{
+    center = vec3(0.0);
+    size = 0.0;
+    angle = 0.0;
+
+    float local = time - aStateless.x * cycleLength;
+    if (local < 0.0) return false; // 还没轮到第一次生成
+
+    // 每个周期换一个种子，同一个槽位每次重生都是一片新的雪花
+    float cycle = floor(local / cycleLength);
+    float age = local - cycle * cycleLength;
+    uint state = hash(uint(aStateless.y) ^ hash(uint(cycle) + 0x9e3779b9u));
+
+    // 随机范围与 ParticleSystem::SpawnParticle 保持一致
+    // 环绕体积时初始位置只要在一个盒子大小的范围内均匀分布即可，之后都会绕回到相机周围
+    vec3 p0 = wrap
+        ? vec3(randRange(state, -wrapHalfExtent, wrapHalfExtent), wrapBottom + randRange(state, 0.0, wrapHeight), randRange(state, -wrapHalfExtent, wrapHalfExtent))
+        : vec3(randRange(state, -50.0, 50.0), randRange(state, 25.0, 80.0), randRange(state, -50.0, 50.0));
+    vec3 v0 = vec3(wind.x + randRange(state, -0.2, 0.2), randRange(state, -0.5, -1.0), wind.z + randRange(state, -0.2, 0.2));
+    float life = randRange(state, 8.0, 18.0);
+    float s = randRange(state, 0.1, 0.2);
+    float phase = randRange(state, 0.0, 6.2831);
+    float swaySpeed = randRange(state, 0.5, 1.5);
+    float angle0 = randRange(state, 0.0, 6.2831);
+    float angularSpeed = randRange(state, -1.0, 1.0);
+    if (age > life) return false;
+
+    // 匀加速运动的解析解
+    vec3 pos = p0 + v0 * age + vec3(0.0, 0.5 * gravity * age * age, 0.0);
+    if (!wrap && pos.y <= killHeight) return false;
+
+    angle = angle0;
+    if (sway)
+    {
+        // 摆动速度 sin/cos(t * swaySpeed + phase) 从生成时刻到现在的积分
+        float a0 = (time - age) * swaySpeed + phase;
+        float a1 = time * swaySpeed + phase;
+        pos.x += swayRate.x / swaySpeed * (cos(a0) - cos(a1));
+        pos.z += swayRate.y / swaySpeed * (sin(a1) - sin(a0));
+        angle += angularSpeed * age;
+    }
+
+    if (wrap)
+    {
+        vec2 lo = wrapCenter - vec2(wrapHalfExtent);
+        pos.xz = lo + mod(pos.xz - lo, vec2(2.0 * wrapHalfExtent));
+        pos.y = wrapBottom + mod(pos.y - wrapBottom, wrapHeight);
+    }
+
+    // 被屋顶等遮挡的部分不可见 (环绕体积中绕回顶部后又会出现)
+    if (occlusion && pos.y <= surfaceHeight(pos.xz)) return false;
+
+    center = pos;
+    size = s;
+    return true;
+}
+
+// 看板(Billboard)：取视图矩阵的右/上方向，让四边形始终正对相机
+vec3 billboard(vec3 center, float size, float angle)
+{
+    vec3 camRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 camUp    = vec3(view[0][1], view[1][1], view[2][1]);
+
+    // 在屏幕平面内旋转四边形，再按粒子大小缩放
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = vec2(c * aPos.x - s * aPos.y, s * aPos.x + c * aPos.y) * size;
+
+    return center + camRight * corner.x + camUp * corner.y;
+}
 
 void main()
 {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    if (stateless)
+    {
+        // 不在生命周期内的雪花大小为 0，退化成不可见的点
+        vec3 center;
+        float size;
+        float angle;
+        statelessFlake(center, size, angle);
+        gl_Position = projection * view * vec4(billboard(center, size, angle), 1.0);
+    }
+    else if (useInstancing)
+    {
+        gl_Position = projection * view * vec4(billboard(aInstance.xyz, aInstance.w, aAngle), 1.0);
+    }
+    else
+    {
+        gl_Position = projection * view * model * vec4(aPos, 1.0);
+    }
 }
\ No newline at end of file
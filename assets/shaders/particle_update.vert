@@ -0,0 +1,153 @@
+﻿#version 330 core
+// 雪花 GPU 模拟 (Transform Feedback)
+// 每个顶点就是一个粒子：读入上一帧的状态，写出这一帧的状态，不做光栅化
+layout (location = 0) in vec4 aPosSize; // xyz = 位置, w = 大小 (死亡粒子大小为 0)
+layout (location = 1) in vec4 aVelLife; // xyz = 速度, w = 剩余寿命
+layout (location = 2) in vec4 aMotion;  // x = 相位, y = 摆动速度, z = 角度, w = 角速度
+
+out vec4 outPosSize;
+out vec4 outVelLife;
+out vec4 outMotion;
+
+uniform float deltaTime;
+uniform float time;
+uniform float gravity;
+uniform float killHeight;
+uniform vec2 swayAmplitude; // 每帧 x/z 方向摆动幅度
+uniform bool sway;          // 小雪时关闭摆动与旋转
+uniform vec3 wind;
+
+// 发射窗口：槽位 [emitStart, emitStart + emitCount) (对 activeCount 取模) 中的空槽位在本帧重生
+// 下标 >= activeCount 的槽位不使用 (会被清空)
+uniform int emitStart;
+uniform int emitCount;
+uniform int activeCount;
+uniform uint seed;
+
+// 相机环绕体积：粒子不再死亡，越过边界就从对面绕回来
+uniform bool wrap;
+uniform vec2 wrapCenter;     // 盒子水平中心 (x, z)
+uniform float wrapHalfExtent;
+uniform float wrapBottom;
+uniform float wrapHeight;
+
+// 降雪遮挡高度图 (PrecipitationOcclusion)：从正上方看的场景深度
+uniform bool occlusion;
+uniform sampler2D occlusionMap;
+uniform vec3 occlusionRect;  // x, z 方向的起点与 1 / 边长
+uniform vec2 occlusionRange; // 高度图的 bottom, top
+
+// 整数哈希，用来在 GPU 上生成随机数
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+float randRange(inout uint state, float a, float b)
+{
+    state = hash(state);
+    return mix(a, b, float(state >> 8) * (1.0 / 16777216.0));
+}
+
+// 该位置第一个遮挡表面的高度 (正交投影深度是线性的；范围以外是边框深度 1，即 bottom)
+float surfaceHeight(vec2 xz)
+{
+    vec2 uv = (xz - occlusionRect.xy) * occlusionRect.z;
+    uv.y = 1.0 - uv.y; // 高度图的 v 方向对应世界 -z
+    float depth = textureLod(occlusionMap, uv, 0.0).r;
+    return mix(occlusionRange.y, occlusionRange.x, depth);
+}
+
+void main()
+{
+    vec3 pos = aPosSize.xyz;
+    float size = aPosSize.w;
+    vec3 vel = aVelLife.xyz;
+    float life = aVelLife.w;
+    vec4 motion = aMotion;
+
+    // 活着看大小而不是寿命：环绕体积里寿命照常递减 (与 CPU 一致) 但不会因此死亡
+    bool alive = size > 0.0;
+    if (alive)
+    {
+        // 与 CPU 版本 (ParticleStore::Update) 相同的积分方式
+        life -= deltaTime;
+        vel.y += gravity * deltaTime;
+        pos += vel * deltaTime;
+
+        if (!wrap && (life <= 0.0 || pos.y <= killHeight))
+        {
+            alive = false;
+        }
+        else if (sway)
+        {
+            float a = time * motion.y + motion.x;
+            pos.x += sin(a) * swayAmplitude.x;
+            pos.z += cos(a) * swayAmplitude.y;
+            motion.z += motion.w * deltaTime;
+        }
+
+        if (wrap)
+        {
+            // 从底部落出的雪花回到顶部，并按相位重置下落速度 (与 ParticleStore 一致)
+            if (pos.y < wrapBottom) vel.y = -0.5 - motion.x * (0.5 / 6.2831);
+            vec2 lo = wrapCenter - vec2(wrapHalfExtent);
+            pos.xz = lo + mod(pos.xz - lo, vec2(2.0 * wrapHalfExtent));
+            pos.y = wrapBottom + mod(pos.y - wrapBottom, wrapHeight);
+        }
+
+        if (alive && occlusion)
+        {
+            // 落到遮挡表面以下：普通模式死亡；环绕体积中回到顶部，表面比顶部还高时死亡 (与 ParticleStore 一致)
+            float surface = surfaceHeight(pos.xz);
+            float respawnY = wrapBottom + wrapHeight * 0.999;
+            if (pos.y <= surface)
+            {
+                if (wrap && surface < respawnY)
+                {
+                    pos.y = respawnY;
+                    vel.y = -0.5 - motion.x * (0.5 / 6.2831);
+                }
+                else
+                {
+                    alive = false;
+                }
+            }
+        }
+    }
+
+    if (gl_VertexID >= activeCount)
+    {
+        alive = false;
+    }
+    else if (!alive && (gl_VertexID - emitStart + activeCount) % activeCount < emitCount)
+    {
+        // 重生：随机范围与 ParticleSystem::SpawnParticle 保持一致
+        uint state = hash(uint(gl_VertexID) ^ seed);
+        pos = wrap
+            ? vec3(wrapCenter.x + randRange(state, -wrapHalfExtent, wrapHalfExtent), wrapBottom + randRange(state, 0.0, wrapHeight), wrapCenter.y + randRange(state, -wrapHalfExtent, wrapHalfExtent))
+            : vec3(randRange(state, -50.0, 50.0), randRange(state, 25.0, 80.0), randRange(state, -50.0, 50.0));
+        vel = vec3(wind.x + randRange(state, -0.2, 0.2), randRange(state, -0.5, -1.0), wind.z + randRange(state, -0.2, 0.2));
+        life = randRange(state, 8.0, 18.0);
+        size = randRange(state, 0.1, 0.2);
+        motion = vec4(randRange(state, 0.0, 6.2831), randRange(state, 0.5, 1.5),
+                      randRange(state, 0.0, 6.2831), randRange(state, -1.0, 1.0));
+        alive = true;
+    }
+
+    if (!alive)
+    {
+        // 死亡粒子：大小置 0，渲染时退化成不可见的点
+        life = 0.0;
+        size = 0.0;
+    }
+
+    outPosSize = vec4(pos, size);
+    outVelLife = vec4(vel, life);
+    outMotion = motion;
+}
@@ -1,11 +1,24 @@
 ﻿#version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aInstanceModel; // 实例化绘制时每个实例的模型矩阵 (占 3~6)
 
-uniform mat4 lightSpaceMatrix; // 光源视角的 投影 * 视图 矩阵
+#define MAX_CASCADES 4
+// 光源视角的 投影 * 视图 矩阵：与 basic.frag 共享同一个块 (FrameUniforms)
+layout (std140) uniform Shadow
+{
+    mat4 lightSpaceMatrices[MAX_CASCADES + 1];
+    vec4 cascadeSplits;
+    vec4 cascadeParams[MAX_CASCADES];
+    int cascadeCount;
+};
+
+uniform int lightSpaceIndex;   // 当前绘制的级联 (MAX_CASCADES 为降雪遮挡高度图)
 uniform mat4 model;            // 模型矩阵
+uniform bool instanced;        // 为 true 时模型矩阵取实例属性，否则取 model
 
 void main()
 {
     // 将顶点转换到光空间
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    mat4 modelMatrix = instanced ? aInstanceModel : model;
+    gl_Position = lightSpaceMatrices[lightSpaceIndex] * modelMatrix * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+﻿#version 330 core
+// 远景雪层：把该层看成以相机为轴、半径为 layerDistance 的圆柱面，
+// 在圆柱面上按网格程序化地生成雪花，并随风与下落速度滚动
+out vec4 FragColor;
+
+in vec2 NdcPos;
+
+uniform mat4 invViewProj;
+uniform vec3 cameraPos;
+uniform float layerDistance;
+uniform uint layerSeed;
+uniform vec2 scroll;        // 滚动偏移 (米)：x 沿圆柱面水平方向, y 沿竖直方向
+uniform float cellSize;     // 每个网格最多一片雪花 (米)
+uniform float density;      // 网格中有雪花的概率 (0~1)
+uniform float flakeRadius;  // 雪花半径 (米)
+uniform float pixelSize;    // 该距离上一个像素对应的世界尺寸 (米)
+uniform float groundHeight;
+uniform float topHeight;
+uniform float time;
+uniform float opacity;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+vec3 cellRandom(ivec2 cell)
+{
+    uint h = hash(uint(cell.x) * 73856093u ^ uint(cell.y) * 19349663u ^ layerSeed);
+    uint h2 = hash(h);
+    uint h3 = hash(h2);
+    return vec3(h >> 8, h2 >> 8, h3 >> 8) * (1.0 / 16777216.0);
+}
+
+void main()
+{
+    // 由屏幕坐标重建视线方向，求它与圆柱面的交点
+    vec4 farPoint = invViewProj * vec4(NdcPos, 1.0, 1.0);
+    vec3 dir = normalize(farPoint.xyz / farPoint.w - cameraPos);
+    float horizontal = length(dir.xz);
+    if (horizontal < 0.05) discard; // 几乎正对天空/地面
+    vec3 p = cameraPos + dir * (layerDistance / horizontal);
+    if (p.y < groundHeight || p.y > topHeight) discard;
+
+    // 水平方向的网格数取整，保证绕一圈后首尾相接
+    float circumference = 6.2831853 * layerDistance;
+    float cellsAround = max(floor(circumference / cellSize), 1.0);
+    vec2 cell = vec2(circumference / cellsAround, cellSize);
+
+    vec2 g = vec2(atan(dir.z, dir.x) * layerDistance + scroll.x, p.y + scroll.y) / cell;
+    vec2 id = floor(g);
+    vec2 f = g - id;
+    id.x = mod(id.x, cellsAround);
+
+    vec3 r = cellRandom(ivec2(id));
+    if (r.z >= density) discard;
+
+    // 雪花在网格内的位置，加一点左右摆动
+    vec2 center = 0.25 + 0.5 * r.xy;
+    center.x += 0.15 * sin(time * (0.5 + r.z) + r.x * 6.2831);
+    float dist = length((f - center) * cell);
+
+    // 小于一个像素的雪花放大到一个像素，再按面积降低不透明度，避免远处闪烁
+    float radius = max(flakeRadius, pixelSize);
+    float alpha = (1.0 - smoothstep(radius * 0.5, radius, dist)) * (flakeRadius * flakeRadius) / (radius * radius);
+    if (alpha <= 0.0) discard;
+
+    FragColor = vec4(vec3(1.2), alpha * opacity);
+}
@@ -0,0 +1,16 @@
+﻿#version 330 core
+// 远景雪层：一个覆盖全屏的四边形，深度放在该层对应的距离上
+// 这样场景中比该层更近的物体会通过深度测试自然遮挡住远处的雪
+layout (location = 0) in vec2 aPos;
+
+out vec2 NdcPos;
+
+uniform mat4 projection;
+uniform float layerDistance;
+
+void main()
+{
+    vec4 clip = projection * vec4(0.0, 0.0, -layerDistance, 1.0);
+    NdcPos = aPos;
+    gl_Position = vec4(aPos, clip.z / clip.w, 1.0);
+}
@@ -4,9 +4,20 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec3 Normal;
 
-uniform vec3 sunColor;
-uniform vec3 viewPos;
-uniform float sunIntensity;
+// 与场景共享的相机与太阳数据 (FrameUniforms)
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+layout (std140) uniform Sun
+{
+    vec3 lightPos;
+    float sunIntensity;
+    vec3 lightColor;     // 太阳的颜色
+    float ambientStrength;
+};
 
 void main()
 {
@@ -18,7 +29,7 @@ void main()
     float glow = pow(centerFactor, 4.0); 
     
     // 颜色混合：中心亮白色，边缘颜色
-    vec3 finalColor = mix(sunColor, vec3(1.1, 1.1, 1.0), glow);
+    vec3 finalColor = mix(lightColor, vec3(1.1, 1.1, 1.0), glow);
 
     // 最后的亮度增益
     finalColor *= sunIntensity;
@@ -8,15 +8,29 @@
 #include "Core/Shader.h"
 #include "Core/Camera.h"
 #include "Core/Collision.h"
+#include "Core/Culling.h"
+#include "Core/OcclusionCuller.h"
 #include "Renderer/Model.h"
+#include "Renderer/AssetLoader.h"
+#include "Renderer/TextureManager.h"
 #include "Renderer/Skybox.h"
+#include "Renderer/LowResParticlePass.h"
+#include "Renderer/FrameGraph.h"
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/GLStateCache.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/ShadowMapCache.h"
+#include "Core/FrameGovernor.h"
 
 #include <iostream>
 #include <algorithm>  // for min/max logic inside main if needed
+#include <functional> // std::hash
 #include "stb_image.h"
 
 //引入下雪场景必要的头文件
 #include "Scene/Scene.h"
+// 场景物体 (模型 + 变换)
+#include "Scene/SceneObject.h"
 
 // 太阳系统
 #include "Scene/SunSystem.h"
@@ -29,8 +43,13 @@ const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
 
 // 模型阴影的边缘清晰度
-//const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024; // 分辨率越高越清晰
-const unsigned int SHADOW_WIDTH = 4096, SHADOW_HEIGHT = 4096; // 高分辨率参数设置，但是对于集显设备可能会在运行过程中卡死
+// 级联阴影：每一级的分辨率 × 级联数。近处的级联只覆盖十几米，2048 就比以前覆盖整个场景的 4096 单张图清晰，
+// 显存与填充开销也更小 (以前 4096 × 4096 对于集显设备可能会在运行过程中卡死)
+const unsigned int SHADOW_RESOLUTION = 2048;
+const int SHADOW_CASCADES = 3;
+
+// 后台加载的模型每帧在主线程上传纹理/网格最多用的时间 (毫秒)，避免加载期间卡顿
+const double ASSET_UPLOAD_BUDGET_MS = 4.0;
 
 // 摄像机系统
 Camera camera(glm::vec3(0.0f, 3.0f, 0.0f));     // 初始位置的确定
@@ -53,29 +72,44 @@ bool altPressed = false;
 bool showColliders = false; // 是否显示空气墙
 unsigned int debugCubeVAO = 0, debugCubeVBO = 0;
 
-// 定义一个结构体，用来管理场景里的每一个物体
-struct SceneObject {
-    Model* model;       // 模型指针
-    glm::vec3 position; // 位置
-    glm::vec3 scale;    // 缩放
-    float rotationAngle; // 旋转角度 (度)
-    glm::vec3 rotationAxis; // 旋转轴
-
-    SceneObject(Model* m, glm::vec3 pos, glm::vec3 s, float rot, glm::vec3 axis)
-        : model(m), position(pos), scale(s), rotationAngle(rot), rotationAxis(axis) {
-    }
-};
-
 // 存储所有场景对象的列表
 std::vector<SceneObject> allObjects;
 
 // 存储所有障碍物的碰撞盒列表
 std::vector<AABB> sceneColliders;
+// 其中可以当作遮挡物的大盒子 (房子、集装箱、巴士)，按 OCCLUDER_SHRINK 向内收缩过，用于软件遮挡剔除
+std::vector<AABB> sceneOccluders;
+const float OCCLUDER_SHRINK = 0.8f;
 
 //下雪场景必要全局变量
 SnowScene snowyScene;
 static double lastToggleTimeF = 0.0;
 static double toggleCooldown = 0.15;
+// 雪花的低分辨率离屏绘制 (1/2/4 倍降采样，F5 切换)，用画质换填充率
+LowResParticlePass particlePass(2);
+// 帧时间调节器：按 CPU/GPU 帧时间自动缩放雪花预算，尽量维持 60 fps (F6 开关)
+FrameGovernor frameGovernor(60.0f);
+// 级联阴影图 + 跨帧缓存：只有相机走出缓存范围、太阳移动或物体变化时才重画对应的级联 (F7 打印投射物剔除统计)
+ShadowMapCache shadowCache(SHADOW_RESOLUTION, SHADOW_CASCADES);
+
+// 场景物体世界包围盒上的 BVH，主 Pass 用它做视锥剔除 (物体变换变化时 Refit)
+BVH sceneBVH;
+size_t sceneBVHHash = 0;
+std::vector<AABB> sceneObjectBounds;    // 与 allObjects 一一对应的世界包围盒
+// 软件遮挡剔除：工作线程把遮挡物光栅化成低分辨率深度，测试每个物体是否被完全挡住 (F8 开关)
+OcclusionCuller occlusionCuller;
+// 场景物体的绘制都经过排序键队列提交，状态切换经过状态缓存 (省掉的调用数 F7 打印)
+GLStateCache stateCache;
+RenderQueue renderQueue;
+// 每帧共享的 uniform 块 (相机、太阳、路灯、阴影)，每帧在所有 Pass 之前写一次
+FrameUniforms frameUniforms;
+// 主 Pass 的视锥/遮挡剔除统计 (F7 打印)
+struct ViewCullStats {
+    unsigned int objects = 0, objectsVisible = 0, objectsOccluded = 0;
+    unsigned int meshes = 0;        // 所有物体的网格总数 (不剔除、不合批时的 DrawCall 数)
+    unsigned int batches = 0, drawCalls = 0;
+};
+ViewCullStats viewCullStats;
 
 // 太阳系统
 SunSystem sunSystem;
@@ -91,13 +125,18 @@ void processInput(GLFWwindow* window);
 // 手动添加一个障碍物 (空气墙)
 // center: 盒子的中心坐标
 // size: 盒子的长宽高 (例如: vec3(10.0f, 5.0f, 1.0f) 代表一面 10米宽、1米厚的墙)
-void addInvisibleWall(glm::vec3 center, glm::vec3 size) {
+// occluder: 盒子里是实心的大物体 (能挡住后面的东西)，同时加入遮挡物列表
+void addInvisibleWall(glm::vec3 center, glm::vec3 size, bool occluder = false) {
     glm::vec3 halfSize = size * 0.5f;
     glm::vec3 min = center - halfSize;
     glm::vec3 max = center + halfSize;
 
     // 直接加入碰撞列表
     sceneColliders.push_back(AABB(min, max));
+
+    // 碰撞盒比模型略大，收缩之后再当遮挡物，避免挡住其实看得见的东西
+    if (occluder)
+        sceneOccluders.push_back(AABB(center - halfSize * OCCLUDER_SHRINK, center + halfSize * OCCLUDER_SHRINK));
 }
 
 // 在空间中建立参考立方体（用于可视化添加碰撞盒子）
@@ -144,33 +183,160 @@ void initSunSystem()
     sunSystem.Init("assets/shaders/sun.vert", "assets/shaders/sun.frag");
 }
 
+// 同一个模型的所有实例：按模型分组后每个网格只需一次实例化 DrawCall，纹理也只绑定一次
+struct InstanceBatch {
+    Model* model;
+    std::vector<glm::mat4> transforms;
+};
+
+// 把一个实例加入对应模型的批次 (批次按模型第一次出现的顺序排列)
+void addInstance(std::vector<InstanceBatch>& batches, Model* model, const glm::mat4& transform)
+{
+    for (auto& batch : batches)
+    {
+        if (batch.model == model)
+        {
+            batch.transforms.push_back(transform);
+            return;
+        }
+    }
+    batches.push_back(InstanceBatch{ model, { transform } });
+}
+
+// 把所有批次提交进渲染队列 (basic 与 shadow_depth 着色器都通过 instanced 切换到实例属性)，排序后执行，返回 DrawCall 数
+unsigned int drawInstanceBatches(Shader& shader, std::vector<InstanceBatch>& batches, RenderPass pass, const Frustum* frustum = nullptr)
+{
+    renderQueue.Begin(pass, camera.Position, 300.0f);
+    for (auto& batch : batches)
+    {
+        if (frustum) batch.model->Submit(renderQueue, shader, batch.transforms, *frustum);
+        else batch.model->Submit(renderQueue, shader, batch.transforms);
+    }
+    batches.clear();
+    return renderQueue.Execute(stateCache);
+}
+
 // 封装的绘制场景函数
 // 参数：当前使用的 Shader
-void drawScene(Shader& shader, const std::vector<SceneObject>& objects, Model& ground)
+void drawScene(Shader& shader, const std::vector<SceneObject>& objects, const SceneObject& ground)
+{
+    static std::vector<InstanceBatch> batches;
+
+    // 1. 所有物体 (重复摆放的模型合并成一个批次)
+    for (const auto& obj : objects)
+        addInstance(batches, obj.model, obj.GetModelMatrix());
+
+    // 2. 地面
+    addInstance(batches, ground.model, ground.GetModelMatrix());
+
+    // 面剔除由队列按命令设置 (物体都关闭面剔除，让树叶双面可见)
+    drawInstanceBatches(shader, batches, RenderPass::Depth);
+}
+
+// 阴影 Pass 专用的绘制函数：与 drawScene 相同，但先按级联剔除不可能投下可见阴影的物体
+void drawShadowCasters(Shader& shader, const std::vector<SceneObject>& objects, const SceneObject& ground, int cascade)
 {
-    // 绘制物体时关闭剔除，让树叶双面可见！
-    glDisable(GL_CULL_FACE);
+    static std::vector<InstanceBatch> batches;
 
-    // 1. 绘制所有物体
     for (const auto& obj : objects)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, obj.position);
-        model = glm::rotate(model, glm::radians(obj.rotationAngle), obj.rotationAxis);
-        model = glm::scale(model, obj.scale);
-        shader.setMat4("model", model);
-        obj.model->Draw(shader);
-    }
-
-    // 2. 绘制地面
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(25.0f, 0.0f, -25.0f));
-    model = glm::scale(model, glm::vec3(0.25f));
-    shader.setMat4("model", model);
-    ground.Draw(shader);
-
-    // 画完可以开回来，或者就一直关着也行
-    glEnable(GL_CULL_FACE);
+        if (shadowCache.CullCaster(cascade, obj.GetWorldBounds())) continue;
+        addInstance(batches, obj.model, obj.GetModelMatrix());
+    }
+
+    if (!shadowCache.CullCaster(cascade, ground.GetWorldBounds()))
+        addInstance(batches, ground.model, ground.GetModelMatrix());
+
+    drawInstanceBatches(shader, batches, RenderPass::Depth);
+}
+
+// 主 Pass 专用的绘制函数：与 drawScene 相同，但只画 BVH 视锥查询可见、且没有被遮挡物完全挡住的物体，
+// 每个批次内再逐网格剔除 (网格在所有实例下都看不见时跳过)
+void drawVisibleScene(Shader& shader, const std::vector<SceneObject>& objects, const SceneObject& ground, const Frustum& frustum)
+{
+    static std::vector<int> visible;
+    static std::vector<InstanceBatch> batches;
+    visible.clear();
+    sceneBVH.Query(frustum, visible);
+    // 按 allObjects 的顺序组批次 (最终顺序由队列的排序键决定：着色器、材质、由近到远)
+    std::sort(visible.begin(), visible.end());
+
+    // 取工作线程上的遮挡剔除结果 (通常早已算完)
+    occlusionCuller.Wait();
+
+    viewCullStats = ViewCullStats();
+    viewCullStats.objects = (unsigned int)objects.size() + 1;
+    for (const auto& obj : objects)
+        viewCullStats.meshes += (unsigned int)obj.model->meshes.size();
+    viewCullStats.meshes += (unsigned int)ground.model->meshes.size();
+
+    for (int index : visible)
+    {
+        if (occlusionCuller.IsOccluded(index))
+        {
+            ++viewCullStats.objectsOccluded;
+            continue;
+        }
+        addInstance(batches, objects[index].model, objects[index].GetModelMatrix());
+        ++viewCullStats.objectsVisible;
+    }
+
+    if (frustum.TestAABB(ground.GetWorldBounds()) != CullResult::Outside)
+    {
+        addInstance(batches, ground.model, ground.GetModelMatrix());
+        ++viewCullStats.objectsVisible;
+    }
+
+    viewCullStats.batches = (unsigned int)batches.size();
+    viewCullStats.drawCalls = drawInstanceBatches(shader, batches, RenderPass::Opaque, &frustum);
+}
+
+// 打印主 Pass 的视锥剔除统计，以及每一级阴影最近一次重建时的投射物剔除统计
+void printCullStats()
+{
+    printf("View culling: %u/%u objects in %u instanced batches, %u draw calls (%u meshes without culling/instancing) (BVH: %u nodes visited, %u objects tested)\n",
+        viewCullStats.objectsVisible, viewCullStats.objects, viewCullStats.batches, viewCullStats.drawCalls, viewCullStats.meshes,
+        sceneBVH.GetLastStats().nodesVisited, sceneBVH.GetLastStats().objectsTested);
+    const OcclusionCuller::Stats& occlusion = occlusionCuller.GetLastStats();
+    printf("Occlusion culling: %s, %u occluded after frustum culling (%u/%u occluders drawn, %u triangles, %.2f ms on worker)\n",
+        occlusionCuller.IsEnabled() ? "ON" : "OFF", viewCullStats.objectsOccluded,
+        occlusion.occluders, (unsigned int)sceneOccluders.size(), occlusion.triangles, occlusion.milliseconds);
+    const GLStateCache::Stats& state = stateCache.GetLastFrameStats();
+    printf("GL state cache (last frame, issued/elided): program %u/%u, VAO %u/%u, texture %u/%u, enable/disable %u/%u, instance buffer %u/%u\n",
+        state.program.issued, state.program.elided, state.vertexArray.issued, state.vertexArray.elided,
+        state.texture.issued, state.texture.elided, state.capability.issued, state.capability.elided,
+        state.instanceBuffer.issued, state.instanceBuffer.elided);
+    printf("Shadow casters:");
+    for (int i = 0; i < shadowCache.GetCascadeCount(); ++i)
+    {
+        const ShadowCullStats& stats = shadowCache.GetCullStats(i);
+        printf(" [cascade %d: %u/%u drawn, %u outside, %u too small]", i, stats.drawn, stats.tested, stats.outside, stats.tooSmall);
+    }
+    printf("\n");
+}
+
+// 所有投射物变换的哈希：物体移动/旋转/缩放、增删或有模型加载完成时变化，用来判断阴影图缓存是否失效
+size_t computeCasterHash(const std::vector<SceneObject>& objects)
+{
+    size_t hash = objects.size();
+    auto combine = [&hash](size_t value) {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+    std::hash<float> hashFloat;
+    // 模型加载完成后包围盒与网格才确定
+    combine(AssetLoader::Get().GetCompletedAssets());
+    for (const auto& obj : objects)
+    {
+        combine(std::hash<const Model*>()(obj.model));
+        for (int i = 0; i < 3; ++i)
+        {
+            combine(hashFloat(obj.position[i]));
+            combine(hashFloat(obj.scale[i]));
+            combine(hashFloat(obj.rotationAxis[i]));
+        }
+        combine(hashFloat(obj.rotationAngle));
+    }
+    return hash;
 }
 
 int main()
@@ -233,30 +399,35 @@ int main()
     // 加载 GLTF 模型前，通常建议关闭翻转，否则纹理会反
     stbi_set_flip_vertically_on_load(false);
 
+    // 模型在后台线程加载 (导入与纹理解码并行)，窗口先开始渲染，每个模型加载完成后出现在场景里
+    AssetLoader& assetLoader = AssetLoader::Get();
+    assetLoader.Start();
     std::cout << "Loading Model..." << std::endl;
     // 请确保 assets/models/***/***.gltf 存在，否则程序会报错, 如果加载失败也会在控制台输出
-    Model houseModel("assets/models/snowy_wooden_hut/scene.gltf");
-    Model groundModel("assets/models/snow_floor/scene.gltf");
-    Model snowmanModel("assets/models/snow_man/scene.gltf");
-    Model house2Model("assets/models/lowpoly_snow_house/scene.gltf");
-    Model treesModel("assets/models/newtrees/scene.gltf");
-    Model wellModel("assets/models/old_well/scene.gltf");
-    Model containerModel("assets/models/rusty_container/scene.gltf");
-    Model busModel("assets/models/bus/scene.gltf");
-    Model villageModel("assets/models/snowy_village/scene.gltf");
-    Model mailboxModel("assets/models/mailbox/scene.gltf");
-    Model christmasTreesModel("assets/models/christmas_tree/scene.gltf");
-    Model benchModel("assets/models/bench/scene.gltf");
-    Model lampModel("assets/models/street_lamp/scene.gltf");
-    Model jonModel("assets/models/jon_snow/scene.gltf");
-    Model dragonModel("assets/models/snow_dragon/scene.gltf");
-    Model reslerianaModel("assets/models/resleriana/scene.gltf");
-    Model fairyModel("assets/models/garden_fairy/scene.gltf");
-    Model figure1("assets/models/figure1/scene.gltf");
-    Model figure2("assets/models/figure2/scene.gltf");
-    Model fountain("assets/models/fountain/scene.gltf");
-
-    std::cout << "Model Loaded!" << std::endl;
+    Model houseModel("assets/models/snowy_wooden_hut/scene.gltf", assetLoader);
+    Model groundModel("assets/models/snow_floor/scene.gltf", assetLoader);
+    Model snowmanModel("assets/models/snow_man/scene.gltf", assetLoader);
+    Model house2Model("assets/models/lowpoly_snow_house/scene.gltf", assetLoader);
+    Model treesModel("assets/models/newtrees/scene.gltf", assetLoader);
+    Model wellModel("assets/models/old_well/scene.gltf", assetLoader);
+    Model containerModel("assets/models/rusty_container/scene.gltf", assetLoader);
+    Model busModel("assets/models/bus/scene.gltf", assetLoader);
+    Model villageModel("assets/models/snowy_village/scene.gltf", assetLoader);
+    Model mailboxModel("assets/models/mailbox/scene.gltf", assetLoader);
+    Model christmasTreesModel("assets/models/christmas_tree/scene.gltf", assetLoader);
+    Model benchModel("assets/models/bench/scene.gltf", assetLoader);
+    Model lampModel("assets/models/street_lamp/scene.gltf", assetLoader);
+    Model jonModel("assets/models/jon_snow/scene.gltf", assetLoader);
+    Model dragonModel("assets/models/snow_dragon/scene.gltf", assetLoader);
+    Model reslerianaModel("assets/models/resleriana/scene.gltf", assetLoader);
+    Model fairyModel("assets/models/garden_fairy/scene.gltf", assetLoader);
+    Model figure1("assets/models/figure1/scene.gltf", assetLoader);
+    Model figure2("assets/models/figure2/scene.gltf", assetLoader);
+    Model fountain("assets/models/fountain/scene.gltf", assetLoader);
+
+
+    // 地面 (外部模型) 单独作为一个物体，不参与 allObjects 的配置
+    SceneObject groundObject(&groundModel, glm::vec3(25.0f, 0.0f, -25.0f), glm::vec3(0.25f), 0.0f, glm::vec3(0, 1, 0));
 
     initDebugCube();
     // =================================================================================
@@ -316,13 +487,13 @@ int main()
     // 参数：中心点(0, 2, -45)， 尺寸(宽10，高10，厚10)
     
     // 空气墙
-    addInvisibleWall(glm::vec3(0.0f, 3.0f, -40.0f), glm::vec3(6.0f, 8.0f, 6.0f)); // 龙旁边的房子
-    addInvisibleWall(glm::vec3(0.0f, 0.5f, 19.0f), glm::vec3(23.0f, 15.0f, 15.0f)); // 树旁边的房子
-    addInvisibleWall(glm::vec3(-27.0f, 7.0f, -6.5f), glm::vec3(10.0f, 14.0f, 13.0f)); // 三栋中靠车的房子
-    addInvisibleWall(glm::vec3(-25.0f, 7.0f, -19.5f), glm::vec3(11.0f, 14.0f, 10.5f)); // 三栋中居中的房子
-    addInvisibleWall(glm::vec3(-25.0f, 7.0f, -30.8f), glm::vec3(10.5f, 18.0f, 10.0f)); // 三栋中靠龙的房子
-    addInvisibleWall(glm::vec3(-25.0f, 3.0f, 20.0f), glm::vec3(8.0f, 8.0f, 17.0f)); // 集装箱
-    addInvisibleWall(glm::vec3(-35.0f, 4.0f, 20.5f), glm::vec3(7.0f, 8.0f, 18.0f)); // 巴士
+    addInvisibleWall(glm::vec3(0.0f, 3.0f, -40.0f), glm::vec3(6.0f, 8.0f, 6.0f), true); // 龙旁边的房子
+    addInvisibleWall(glm::vec3(0.0f, 0.5f, 19.0f), glm::vec3(23.0f, 15.0f, 15.0f), true); // 树旁边的房子
+    addInvisibleWall(glm::vec3(-27.0f, 7.0f, -6.5f), glm::vec3(10.0f, 14.0f, 13.0f), true); // 三栋中靠车的房子
+    addInvisibleWall(glm::vec3(-25.0f, 7.0f, -19.5f), glm::vec3(11.0f, 14.0f, 10.5f), true); // 三栋中居中的房子
+    addInvisibleWall(glm::vec3(-25.0f, 7.0f, -30.8f), glm::vec3(10.5f, 18.0f, 10.0f), true); // 三栋中靠龙的房子
+    addInvisibleWall(glm::vec3(-25.0f, 3.0f, 20.0f), glm::vec3(8.0f, 8.0f, 17.0f), true); // 集装箱
+    addInvisibleWall(glm::vec3(-35.0f, 4.0f, 20.5f), glm::vec3(7.0f, 8.0f, 18.0f), true); // 巴士
     // 喷泉的空气墙绘制
     addInvisibleWall(glm::vec3(-0.4f, 2.0f, -15.8f), glm::vec3(7.0f, 7.0f, 7.0f));
     addInvisibleWall(glm::vec3(-0.4f, 2.0f, -15.8f), glm::vec3(8.0f, 7.0f, 6.0f));
@@ -371,47 +542,86 @@ int main()
 
     // 4. 渲染循环
     // ==========================================
-    // 配置阴影贴图 FBO
+    // 帧图：每帧声明 Pass 及其读写的资源，由帧图排序、剔除并管理临时渲染目标
     // ==========================================
-    unsigned int depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
-
-    // 创建深度纹理
-    unsigned int depthMap;
-    glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT,
-        SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-
-    // 设置纹理过滤
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    // 设置纹理环绕 (防止阴影以外的区域变黑)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-
-    // 绑定到 FBO
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-    glDrawBuffer(GL_NONE); // 不需要颜色
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    FrameGraph frameGraph;
+    bool frameGraphReported = false;
+
+    // 级联阴影图 (纹理数组与每一级的 FBO)
+    shadowCache.Init();
+
+    // 软件遮挡剔除的工作线程
+    occlusionCuller.SetOccluders(sceneOccluders);
+    occlusionCuller.Start();
 
     // 加载阴影 Shader
     Shader depthShader("assets/shaders/shadow_depth.vert", "assets/shaders/shadow_depth.frag");
 
-    // 配置主 Shader 的阴影纹理槽位 (设为 15，避开模型自带纹理)
-    ourShader.use();
+    // 每帧共享的 uniform 块：主 Shader 与阴影 Shader 连到对应的绑定点 (粒子、太阳、天空盒在各自初始化时连接)
+    frameUniforms.Init();
+    FrameUniforms::BindBlocks(ourShader.ID);
+    FrameUniforms::BindBlocks(depthShader.ID);
+    // 帧循环里还要单独设置的 uniform，提前解析好位置
+    Uniform<int> lightSpaceIndexUniform = depthShader.getUniform<int>("lightSpaceIndex");
+    Uniform<glm::mat4> modelUniform = ourShader.getUniform<glm::mat4>("model");
+
+    // 配置主 Shader 的纹理槽位：材质纹理按类型固定在 0~8 号单元，阴影纹理设为 15，避开模型自带纹理
+    Mesh::SetSamplerUnits(ourShader);
     ourShader.setInt("shadowMap", 15);
 
+    // ===========================================
+    // 【升级】4 盏路灯的参数 (位置与衰减不变，只写一次；开关每帧更新)
+    // ===========================================
+    {
+        // 灯泡的偏移高度 (灯杆高 2.0 倍，灯泡大概在 7.0 高度)
+        float lampHeightOffset = 7.0f;
+
+        // 定义 4 盏灯的底座坐标 (跟上面添加模型的坐标保持一致)
+        glm::vec3 lampPositions[FrameUniforms::MAX_LAMPS] = {
+            glm::vec3(-17.0f, 0.0f, 15.0f),  // 1. 原路灯
+            glm::vec3(-8.0f, 0.0f, -12.0f),  // 2. 喷泉路灯
+            glm::vec3(22.0f, 0.0f, 10.0f),   // 3. 长椅路灯
+            glm::vec3(6.0f, 0.0f, -40.0f)  // 4. 村庄路灯
+        };
+
+        for (int i = 0; i < FrameUniforms::MAX_LAMPS; i++)
+        {
+            FrameUniforms::PointLight& light = frameUniforms.lamps.pointLights[i];
+            // 位置：底座坐标 + 高度偏移
+            light.position = lampPositions[i] + glm::vec3(0.0f, lampHeightOffset, 0.0f);
+            // 颜色：暖黄光
+            light.color = glm::vec3(1.0f, 0.8f, 0.4f);
+            // 衰减参数 (覆盖范围约 50 米)
+            light.constant = 1.0f;
+            light.linear = 0.09f;
+            light.quadratic = 0.032f;
+        }
+    }
+
     // 4. 渲染循环
+    unsigned int loadedAssets = 0;
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        frameGovernor.BeginFrame();
+
+        // 后台加载完的模型：在预算内上传纹理与网格 (直接调用 GL，所以放在状态缓存重置之前)
+        assetLoader.Update(ASSET_UPLOAD_BUDGET_MS);
+        if (assetLoader.GetCompletedAssets() != loadedAssets)
+        {
+            loadedAssets = assetLoader.GetCompletedAssets();
+            // 场景里出现了新模型，降雪遮挡高度图重新绘制 (阴影与 BVH 由物体哈希触发)
+            snowyScene.GetOcclusion().MarkDirty();
+            if (assetLoader.GetPendingAssets() == 0)
+            {
+                std::cout << "Model Loaded!" << std::endl;
+                TextureManager::Get().PrintReport();
+            }
+        }
+        // 上一帧结尾 (天空盒、雪花等) 直接改过 GL 状态，缓存从未知开始
+        stateCache.BeginFrame();
 
         // ==========================================
         // 碰撞检测回退逻辑
@@ -453,193 +663,237 @@ int main()
         camera.RotationSmoothSpeed = 15.0f;
         camera.MouseSensitivity = 0.8f;
 
-        // 清屏
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // 默认帧缓冲的实际尺寸 (窗口大小可能变化)
+        int fbWidth = 0, fbHeight = 0;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        fbHeight = std::max(fbHeight, 1);
+        float aspect = (float)fbWidth / (float)fbHeight;
 
-        // 更新下雪粒子 (必须在每一帧开始时做)
-        snowyScene.Update(deltaTime);
+        // 相机在这之后不再变化，投影/视图矩阵在帧开始就确定下来
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 300.0f);
+        // 这里 GetViewMatrix()
+        glm::mat4 view = camera.GetViewMatrix();
 
-        // 太阳系统
-        sunSystem.Update(deltaTime, dayTime);
+        // 物体变换的哈希：阴影缓存与场景 BVH 都用它判断物体是否变化
+        size_t casterHash = computeCasterHash(allObjects);
 
-        ourShader.use();
+        // 场景 BVH：物体变换变化时 Refit (第一次或物体数量变化时重新构建)
+        if (sceneBVH.GetObjectCount() != allObjects.size() || casterHash != sceneBVHHash)
+        {
+            sceneObjectBounds.clear();
+            sceneObjectBounds.reserve(allObjects.size());
+            for (const auto& obj : allObjects)
+                sceneObjectBounds.push_back(obj.GetWorldBounds());
+            sceneBVH.Refit(sceneObjectBounds);
+            sceneBVHHash = casterHash;
+        }
+        Frustum viewFrustum = Frustum::FromMatrix(projection * view);
 
-        //      // 设置光照和相机矩阵
-        //      ourShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));       // (1.0, 1.0, 1.0) 代表纯白色光。
-              //ourShader.setVec3("lightPos", glm::vec3(0.0f, 20.0f, 0.0f));         // 光源位置
-        //      ourShader.setVec3("viewPos", camera.Position);
+        // 遮挡剔除交给工作线程，与下面的粒子更新、阴影绘制 (以及 GPU 上还没画完的上一帧) 并行，主 Pass 绘制前再取结果
+        occlusionCuller.Submit(projection * view, sceneObjectBounds);
 
+        // 更新下雪粒子 (必须在每一帧开始时做)
+        // 天气预设只决定"想要多大的雪"，实际的粒子预算由帧时间调节器决定
+        snowyScene.SetBudgetScale(frameGovernor.GetBudgetScale());
+        snowyScene.Update(deltaTime, camera);
 
-        //// 定义光源位置 (需要固定，不能乱跑)
-        //glm::vec3 lightPos(10.0f, 20.0f, 10.0f); // 模拟太阳，放高一点
+        // 太阳系统
+        sunSystem.Update(deltaTime, dayTime);
 
         // 太阳系统
         glm::vec3 lightPos = sunSystem.worldPos;
 
-        // ============================================================
-        // 1. 第一遍渲染：从光源视角生成深度图 (Shadow Pass)
-        // ============================================================
-
-        // 计算光空间矩阵 (正交投影适合定向光/太阳光)
-        float near_plane = 1.0f, far_plane = 300.0f;
-        // 下面的参数决定了阴影覆盖的范围，太小会导致远处没影子，太大导致影子模糊
-        glm::mat4 lightProjection = glm::ortho(-80.0f, 80.0f, -80.0f, 80.0f, near_plane, far_plane);
-        glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0)); // 使用 sunSystem.worldPos 作为 lightPos 计算 lightSpaceMatrix
-        glm::mat4 lightSpaceMatrix = lightProjection * lightView;
-
-        depthShader.use();
-        depthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT); // 切换到阴影图分辨率
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // 【技巧】渲染阴影时使用正面剔除，可以极大减少“阴影悬浮”问题
-        glCullFace(GL_FRONT);
-
-        // 调用我们提取出来的绘制函数
-        drawScene(depthShader, allObjects, groundModel);
-
-        glCullFace(GL_BACK); // 改回背面剔除
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // 【技巧】渲染阴影时使用正面剔除，可以极大减少“阴影悬浮”问题
-        glCullFace(GL_FRONT);
-
-        // 调用我们提取出来的绘制函数
-        drawScene(depthShader, allObjects, groundModel);
-
-        glCullFace(GL_BACK); // 改回背面剔除
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // 级联阴影：按相机视锥切分并拟合每一级；相机走出缓存范围、太阳方向超过阈值或物体变换变化时
+        // 只重画受影响的级联，其余级联 (通常是全部) 本帧不需要 Shadow Pass
+        unsigned int dirtyCascades = shadowCache.Update(view, glm::radians(camera.Zoom), aspect, 0.1f,
+            sunSystem.direction, casterHash);
+
+        // 本帧共享的 uniform 块：相机、太阳、路灯开关与阴影级联，一次写入，所有 Pass 共用
+        frameUniforms.camera.projection = projection;
+        frameUniforms.camera.view = view;
+        frameUniforms.camera.viewPos = camera.Position;
+        // 太阳系统：将太阳的实时数据传给场景物体、太阳本身的着色器
+        frameUniforms.sun.lightPos = lightPos;                      // 太阳光方向由它算出
+        frameUniforms.sun.lightColor = sunSystem.color;             // 太阳光颜色
+        frameUniforms.sun.sunIntensity = sunSystem.intensity;       // 太阳光强度
+        frameUniforms.sun.ambientStrength = sunSystem.ambient;      // 随时间变化的环境光
+        // 总开关 (受 G 键控制)
+        frameUniforms.lamps.lampOn = isLampOn ? 1 : 0;
+        // 级联阴影：每一级的矩阵、覆盖深度与换算偏移用的参数；最后一个矩阵给降雪遮挡高度图
+        frameUniforms.shadow.cascadeCount = shadowCache.GetCascadeCount();
+        for (int i = 0; i < shadowCache.GetCascadeCount(); ++i)
+        {
+            frameUniforms.shadow.lightSpaceMatrices[i] = shadowCache.GetLightSpaceMatrix(i);
+            frameUniforms.shadow.cascadeSplits[i] = shadowCache.GetSplitDistance(i);
+            frameUniforms.shadow.cascadeParams[i] = glm::vec4(shadowCache.GetTexelWorldSize(i), shadowCache.GetDepthRange(i), 0.0f, 0.0f);
+        }
+        frameUniforms.shadow.lightSpaceMatrices[FrameUniforms::OCCLUSION_LIGHT_SPACE] = snowyScene.GetOcclusion().GetViewProjection();
+        frameUniforms.Upload();
 
         // ============================================================
-        // 2. 第二遍渲染：正常绘制场景 (Render Pass)
+        // 声明本帧的 Pass (执行顺序由读写关系决定)
         // ============================================================
-        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT); // 恢复屏幕分辨率
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        ourShader.use();
-
-        // ===========================================
-        // 【升级】传递 4 盏路灯的参数
-        // ===========================================
-
-        // 灯泡的偏移高度 (灯杆高 2.0 倍，灯泡大概在 7.0 高度)
-        float lampHeightOffset = 7.0f;
-
-        // 定义 4 盏灯的底座坐标 (跟上面添加模型的坐标保持一致)
-        glm::vec3 lampPositions[] = {
-            glm::vec3(-17.0f, 0.0f, 15.0f),  // 1. 原路灯
-            glm::vec3(-8.0f, 0.0f, -12.0f),  // 2. 喷泉路灯
-            glm::vec3(22.0f, 0.0f, 10.0f),   // 3. 长椅路灯
-            glm::vec3(6.0f, 0.0f, -40.0f)  // 4. 村庄路灯
-        };
-
-        // 循环传递数组给 Shader
-        for (int i = 0; i < 4; i++)
+        frameGraph.Reset();
+        FrameGraphResource backbuffer = frameGraph.ImportRenderTarget("Backbuffer", 0, fbWidth, fbHeight);
+        // 每个级联是纹理数组的一层，各自作为一个外部渲染目标
+        static const char* cascadeNames[ShadowMapCache::MAX_CASCADES] = { "ShadowCascade0", "ShadowCascade1", "ShadowCascade2", "ShadowCascade3" };
+        FrameGraphResource shadowCascades[ShadowMapCache::MAX_CASCADES];
+        for (int i = 0; i < shadowCache.GetCascadeCount(); ++i)
         {
-            std::string number = std::to_string(i);
-
-            // 位置：底座坐标 + 高度偏移
-            ourShader.setVec3("pointLights[" + number + "].position", lampPositions[i] + glm::vec3(0.0f, lampHeightOffset, 0.0f));
-
-            // 颜色：暖黄光
-            ourShader.setVec3("pointLights[" + number + "].color", glm::vec3(1.0f, 0.8f, 0.4f));
-
-            // 衰减参数 (覆盖范围约 50 米)
-            ourShader.setFloat("pointLights[" + number + "].constant", 1.0f);
-            ourShader.setFloat("pointLights[" + number + "].linear", 0.09f);
-            ourShader.setFloat("pointLights[" + number + "].quadratic", 0.032f);
+            shadowCascades[i] = frameGraph.ImportRenderTarget(cascadeNames[i], shadowCache.GetFramebuffer(i),
+                shadowCache.GetResolution(), shadowCache.GetResolution(), 0, shadowCache.GetDepthTexture());
         }
 
-        // 总开关 (受 G 键控制)
-        ourShader.setBool("lampOn", isLampOn);
-        
-        // 太阳系统
-        // 将太阳的实时数据传给场景物体的着色器
-        ourShader.setVec3("lightPos", lightPos);      // 太阳光方向
-        ourShader.setVec3("lightColor", sunSystem.color);        // 太阳光颜色
-        ourShader.setFloat("sunIntensity", sunSystem.intensity); // 太阳光强度
-        ourShader.setFloat("ambientStrength", sunSystem.ambient); // 随时间变化的环境光
-        ourShader.setMat4("lightSpaceMatrix", lightSpaceMatrix); // 阴影矩阵
-        ourShader.setVec3("viewPos", camera.Position);
-
-
-        // 绑定阴影贴图到 15 号槽
-        glActiveTexture(GL_TEXTURE15);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-            (float)SCR_WIDTH / (float)SCR_HEIGHT,
-            0.1f, 300.0f);
-        ourShader.setMat4("projection", projection);
-
-        // 这里 GetViewMatrix()
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("view", view);
-
-        // 绘制场景
-        drawScene(ourShader, allObjects, groundModel);
+        // 降雪遮挡高度图：从正上方把场景画成深度，雪花落到第一个表面就停下 (不会穿过屋顶)
+        // 场景是静态的，只在第一帧 (或 MarkDirty 之后) 绘制一次；结果是 CPU 端高度图，所以声明为副作用
+        PrecipitationOcclusion& snowOcclusion = snowyScene.GetOcclusion();
+        if (snowOcclusion.IsDirty())
+        {
+            frameGraph.AddPass("SnowOcclusion",
+                [&](FrameGraph::Builder& builder) { builder.SideEffect(); },
+                [&](const FrameGraph&) {
+                    stateCache.UseProgram(depthShader.ID);
+                    depthShader.set(lightSpaceIndexUniform, FrameUniforms::OCCLUSION_LIGHT_SPACE);
+                    snowOcclusion.Begin();
+                    drawScene(depthShader, allObjects, groundObject);
+                    snowOcclusion.End();
+                });
+        }
 
-        // 地面 (外部模型) 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(25.0f, 0.0f, -25.0f));
-        model = glm::scale(model, glm::vec3(0.25f));
-        ourShader.setMat4("model", model);
-        groundModel.Draw(ourShader);
+        // 1. 从光源视角生成深度图 (Shadow Pass)，只为缓存失效的级联声明
+        for (int i = 0; i < shadowCache.GetCascadeCount(); ++i)
+        {
+            if (!(dirtyCascades & (1u << i))) continue;
+            frameGraph.AddPass(cascadeNames[i],
+                [&, i](FrameGraph::Builder& builder) { builder.Write(shadowCascades[i]); },
+                [&, i](const FrameGraph&) {
+                    stateCache.UseProgram(depthShader.ID);
+                    depthShader.set(lightSpaceIndexUniform, i);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+
+                    // 【技巧】渲染阴影时使用正面剔除，可以极大减少“阴影悬浮”问题
+                    glCullFace(GL_FRONT);
+                    // 深度钳制：比近平面更靠近太阳的投射物压到近平面上，而不是被裁掉
+                    glEnable(GL_DEPTH_CLAMP);
+                    drawShadowCasters(depthShader, allObjects, groundObject, i);
+                    glDisable(GL_DEPTH_CLAMP);
+                    glCullFace(GL_BACK); // 改回背面剔除
+                });
+        }
 
-        // 但为了防止至暗时刻(强度为0)天空完全变成死黑，我们给一个最低亮度 0.05
-        float skyBrightness = std::max(sunSystem.intensity, 0.05f);
-        // 如果是白天，可以稍微降低一点亮度，防止天空过曝太白 (可选)
-        if (skyBrightness > 1.0f) skyBrightness = 1.0f;
-        // 调用 Draw，传入计算好的亮度
-        skybox->Draw(view, projection, skyBrightness);
+        // 2. 正常绘制场景 (Render Pass)
+        frameGraph.AddPass("Scene",
+            [&](FrameGraph::Builder& builder) {
+                for (int i = 0; i < shadowCache.GetCascadeCount(); ++i)
+                    builder.Read(shadowCascades[i]);
+                builder.Write(backbuffer);
+            },
+            [&](const FrameGraph& graph) {
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                // 经过状态缓存切换程序与绑定纹理，后面队列执行时不会重复设置
+                // 相机、太阳、路灯与阴影参数都在共享的 uniform 块里 (帧开始时已写入)
+                stateCache.UseProgram(ourShader.ID);
+
+                // 绑定阴影贴图到 15 号槽
+                stateCache.BindTexture(15, GL_TEXTURE_2D_ARRAY, graph.GetTexture(shadowCascades[0]));
+                stateCache.ActiveTexture(0);
+
+                // 绘制场景 (地面也在里面)，视锥外的物体与网格直接跳过
+                drawVisibleScene(ourShader, allObjects, groundObject, viewFrustum);
+            });
+
+        frameGraph.AddPass("Skybox",
+            [&](FrameGraph::Builder& builder) { builder.Write(backbuffer); },
+            [&](const FrameGraph&) {
+                // 但为了防止至暗时刻(强度为0)天空完全变成死黑，我们给一个最低亮度 0.05
+                float skyBrightness = std::max(sunSystem.intensity, 0.05f);
+                // 如果是白天，可以稍微降低一点亮度，防止天空过曝太白 (可选)
+                if (skyBrightness > 1.0f) skyBrightness = 1.0f;
+                // 调用 Draw，传入计算好的亮度
+                skybox->Draw(skyBrightness);
+            });
 
         // 绘制空气墙
         if (showColliders) {
-            // 使用线框模式
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-            // 这里可以使用一个简单的纯色 shader，或者复用 ourShader 但忽略纹理
-            // 为了简单，我们复用 ourShader，但需要一个纯白纹理（你之前在 Model.cpp 里写的 GetDefaultWhiteTexture 很有用）
-            // 或者简单粗暴地利用 basic.frag 的特性（如果没有绑定材质，可能会变黑，但线框能看清就行）
-
-            ourShader.use();
-            ourShader.setVec3("lightColor", glm::vec3(1.0f)); // 确保够亮
-
-            glBindVertexArray(debugCubeVAO);
-
-            for (const auto& box : sceneColliders) {
-                // 计算中心点和大小
-                glm::vec3 size = box.max - box.min;
-                glm::vec3 center = box.min + size * 0.5f;
-
-                glm::mat4 model = glm::mat4(1.0f);
-                model = glm::translate(model, center);
-                model = glm::scale(model, size); // 缩放成盒子大小
-
-                ourShader.setMat4("model", model);
-                // 线框绘制
-                glDrawArrays(GL_LINES, 0, 24);
-            }
-
-            // 恢复填充模式
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            frameGraph.AddPass("Colliders",
+                [&](FrameGraph::Builder& builder) { builder.Write(backbuffer); },
+                [&](const FrameGraph&) {
+                    // 使用线框模式
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+                    // 这里可以使用一个简单的纯色 shader，或者复用 ourShader 但忽略纹理
+                    // 为了简单，我们复用 ourShader，但需要一个纯白纹理（你之前在 Model.cpp 里写的 GetDefaultWhiteTexture 很有用）
+                    // 或者简单粗暴地利用 basic.frag 的特性（如果没有绑定材质，可能会变黑，但线框能看清就行）
+
+                    // 光照参数在共享的 uniform 块里，线框与场景同样受光
+                    ourShader.use();
+
+                    glBindVertexArray(debugCubeVAO);
+
+                    for (const auto& box : sceneColliders) {
+                        // 计算中心点和大小
+                        glm::vec3 size = box.max - box.min;
+                        glm::vec3 center = box.min + size * 0.5f;
+
+                        glm::mat4 model = glm::mat4(1.0f);
+                        model = glm::translate(model, center);
+                        model = glm::scale(model, size); // 缩放成盒子大小
+
+                        ourShader.set(modelUniform, model);
+                        // 线框绘制
+                        glDrawArrays(GL_LINES, 0, 24);
+                    }
+
+                    // 恢复填充模式
+                    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+                });
         }
 
         // 最后绘制雪花 (必须在最后，因为它是半透明的)
-        snowyScene.Render(camera);
+        // 雪花先画到低分辨率目标，再按深度感知上采样合成回屏幕 (近/远平面与上面的主场景投影一致)
+        // 需要读取场景深度，所以同时声明读写默认帧缓冲
+        frameGraph.AddPass("Snow",
+            [&](FrameGraph::Builder& builder) {
+                builder.Read(backbuffer);
+                builder.Write(backbuffer);
+            },
+            [&](const FrameGraph&) {
+                particlePass.Begin(0.1f, 300.0f);
+                snowyScene.Render(camera);
+                particlePass.End();
+            });
 
         // 太阳系统
-        sunSystem.Render(camera);
+        frameGraph.AddPass("Sun",
+            [&](FrameGraph::Builder& builder) { builder.Write(backbuffer); },
+            [&](const FrameGraph&) { sunSystem.Render(); });
+
+        frameGraph.Compile();
+        frameGraph.Execute();
+        // 第一帧打印一次执行顺序，便于确认没有多余的 Pass
+        if (!frameGraphReported)
+        {
+            frameGraph.PrintSummary();
+            printCullStats();
+            frameGraphReported = true;
+        }
 
+        frameGovernor.EndFrame();
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    occlusionCuller.Stop();
+    assetLoader.Stop();
+    // 模型是 main 的局部变量，析构在 glfwTerminate 之后，GL 对象要在上下文销毁前释放 (同一模型可以重复释放)
+    for (auto& obj : allObjects)
+        obj.model->Release(&stateCache);
+    groundObject.model->Release(&stateCache);
+    // 天空盒、雪花等剩下的纹理
+    TextureManager::Get().Clear();
+    particlePass.Release();
     glfwTerminate();
     return 0;
 }
@@ -756,6 +1010,87 @@ void processInput(GLFWwindow* window)
         f1Pressed = false;
     }
 
+    // F2 切换雪花的实例化渲染 / 逐粒子渲染 (A/B 对比性能用)
+    static bool f2Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS && !f2Pressed) {
+        ParticleSystem& ps = snowyScene.GetParticleSystem();
+        ps.SetInstancing(!ps.IsInstancing());
+        f2Pressed = true;
+        printf("Particle render path: %s\n", ps.IsInstancing() ? "INSTANCED" : "PER-PARTICLE");
+    }
+    if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_RELEASE) {
+        f2Pressed = false;
+    }
+
+    // F3 轮流切换雪花模拟模式：CPU (SoA 粒子池) -> GPU (Transform Feedback) -> 无状态 (顶点着色器解析计算)
+    static bool f3Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS && !f3Pressed) {
+        ParticleSystem& ps = snowyScene.GetParticleSystem();
+        static const ParticleSimMode nextMode[] = { ParticleSimMode::GPU, ParticleSimMode::Stateless, ParticleSimMode::CPU };
+        static const char* modeNames[] = { "CPU", "GPU", "STATELESS" };
+        ps.SetSimulationMode(nextMode[(int)ps.GetSimulationMode()]);
+        f3Pressed = true;
+        printf("Particle simulation: %s\n", modeNames[(int)ps.GetSimulationMode()]);
+    }
+    if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_RELEASE) {
+        f3Pressed = false;
+    }
+
+    // F4 切换降雪 LOD (近处真实粒子 + 远处雪层 / 全部使用真实粒子)
+    static bool f4Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS && !f4Pressed) {
+        snowyScene.SetPrecipitationLOD(!snowyScene.IsPrecipitationLOD());
+        f4Pressed = true;
+        printf("Precipitation LOD: %s\n", snowyScene.IsPrecipitationLOD() ? "ON" : "OFF");
+    }
+    if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_RELEASE) {
+        f4Pressed = false;
+    }
+
+    // F5 轮流切换雪花的离屏分辨率：全分辨率 -> 1/2 -> 1/4
+    static bool f5Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS && !f5Pressed) {
+        particlePass.SetDownscale(particlePass.GetDownscale() >= 4 ? 1 : particlePass.GetDownscale() * 2);
+        f5Pressed = true;
+        printf("Particle resolution: 1/%d\n", particlePass.GetDownscale());
+    }
+    if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_RELEASE) {
+        f5Pressed = false;
+    }
+
+    // F6 开关帧时间调节器 (关闭时雪花预算固定为 100%)
+    static bool f6Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS && !f6Pressed) {
+        frameGovernor.SetEnabled(!frameGovernor.IsEnabled());
+        f6Pressed = true;
+        printf("Frame governor: %s (cpu %.1f ms, gpu %.1f ms)\n", frameGovernor.IsEnabled() ? "ON" : "OFF",
+            frameGovernor.GetCpuMs(), frameGovernor.GetGpuMs());
+    }
+    if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_RELEASE) {
+        f6Pressed = false;
+    }
+
+    // F7 打印剔除统计 (主 Pass 的视锥剔除，以及每一级阴影最近一次重建时画了多少物体、跳过了多少)
+    static bool f7Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS && !f7Pressed) {
+        f7Pressed = true;
+        printCullStats();
+    }
+    if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_RELEASE) {
+        f7Pressed = false;
+    }
+
+    // F8 开关软件遮挡剔除 (对比被房子挡住的物体画与不画的开销)
+    static bool f8Pressed = false;
+    if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_PRESS && !f8Pressed) {
+        occlusionCuller.SetEnabled(!occlusionCuller.IsEnabled());
+        f8Pressed = true;
+        printf("Occlusion culling: %s\n", occlusionCuller.IsEnabled() ? "ON" : "OFF");
+    }
+    if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_RELEASE) {
+        f8Pressed = false;
+    }
+
     //下雪天气开关：O/P, L，O是下中雪、P是停止下雪、L是下大雪，K是下小雪
     if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS){
         snowyScene.setSmallSnow(true);
@@ -0,0 +1,268 @@
+﻿#include "Culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+// x64 上 SSE 总是可用；其他平台退回标量实现
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+AABB TransformAABB(const AABB& box, const glm::mat4& matrix)
+{
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+    glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    glm::mat3 absMatrix = glm::mat3(matrix);
+    for (int c = 0; c < 3; ++c)
+        absMatrix[c] = glm::abs(absMatrix[c]);
+    glm::vec3 newExtent = absMatrix * extent;
+
+    return AABB(newCenter - newExtent, newCenter + newExtent);
+}
+
+AABB MergeAABB(const AABB& a, const AABB& b)
+{
+    return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+// ==========================================
+// Frustum
+// ==========================================
+
+Frustum Frustum::FromMatrix(const glm::mat4& m)
+{
+    // Gribb-Hartmann：平面 = 第 4 行 ± 第 1/2/3 行 (glm 是列主序，m[col][row])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0;    // 左
+    frustum.planes[1] = row3 - row0;    // 右
+    frustum.planes[2] = row3 + row1;    // 下
+    frustum.planes[3] = row3 - row1;    // 上
+    frustum.planes[4] = row3 + row2;    // 近
+    frustum.planes[5] = row3 - row2;    // 远
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+CullResult Frustum::TestAABB(const AABB& box) const
+{
+    CullResult result = CullResult::Inside;
+    for (const auto& plane : planes)
+    {
+        // 最靠内侧的角 (p-vertex) 在平面外：整个盒子在外
+        glm::vec3 positive(plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return CullResult::Outside;
+
+        // 最靠外侧的角 (n-vertex) 在平面外：与这个平面相交
+        glm::vec3 negative(plane.x >= 0.0f ? box.min.x : box.max.x,
+            plane.y >= 0.0f ? box.min.y : box.max.y,
+            plane.z >= 0.0f ? box.min.z : box.max.z);
+        if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+            result = CullResult::Intersect;
+    }
+    return result;
+}
+
+unsigned int Frustum::TestAABB4(const AABB* boxes, int count) const
+{
+    count = std::min(count, 4);
+#ifdef CULLING_USE_SSE
+    // 转成 SoA：4 个盒子的 min.x / max.x ... 各占一个寄存器，不足 4 个时用第一个盒子补齐
+    float minX[4], minY[4], minZ[4], maxX[4], maxY[4], maxZ[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        const AABB& box = boxes[i < count ? i : 0];
+        minX[i] = box.min.x; minY[i] = box.min.y; minZ[i] = box.min.z;
+        maxX[i] = box.max.x; maxY[i] = box.max.y; maxZ[i] = box.max.z;
+    }
+    __m128 bMinX = _mm_loadu_ps(minX), bMinY = _mm_loadu_ps(minY), bMinZ = _mm_loadu_ps(minZ);
+    __m128 bMaxX = _mm_loadu_ps(maxX), bMaxY = _mm_loadu_ps(maxY), bMaxZ = _mm_loadu_ps(maxZ);
+
+    __m128 outside = _mm_setzero_ps();
+    for (const auto& plane : planes)
+    {
+        // 平面法线的符号对 4 个盒子相同，直接选出 p-vertex 的分量
+        __m128 px = plane.x >= 0.0f ? bMaxX : bMinX;
+        __m128 py = plane.y >= 0.0f ? bMaxY : bMinY;
+        __m128 pz = plane.z >= 0.0f ? bMaxZ : bMinZ;
+        __m128 distance = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane.x)), _mm_mul_ps(py, _mm_set1_ps(plane.y))),
+            _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+    }
+    unsigned int visible = ~(unsigned int)_mm_movemask_ps(outside) & 0xFu;
+    return visible & ((1u << count) - 1u);
+#else
+    unsigned int visible = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (TestAABB(boxes[i]) != CullResult::Outside)
+            visible |= 1u << i;
+    }
+    return visible;
+#endif
+}
+
+// ==========================================
+// BVH
+// ==========================================
+
+void BVH::Build(const std::vector<AABB>& bounds)
+{
+    nodes.clear();
+    objectBounds = bounds;
+    objectIndices.resize(bounds.size());
+    if (bounds.empty()) return;
+
+    std::vector<glm::vec3> centers(bounds.size());
+    for (size_t i = 0; i < bounds.size(); ++i)
+    {
+        objectIndices[i] = (int)i;
+        centers[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+    }
+
+    nodes.reserve(bounds.size() * 2);
+    BuildRecursive(0, (int)bounds.size(), centers);
+}
+
+int BVH::BuildRecursive(int first, int count, const std::vector<glm::vec3>& centers)
+{
+    int nodeIndex = (int)nodes.size();
+    nodes.push_back(Node());
+
+    AABB bounds = objectBounds[objectIndices[first]];
+    AABB centerBounds(centers[objectIndices[first]], centers[objectIndices[first]]);
+    for (int i = first + 1; i < first + count; ++i)
+    {
+        bounds = MergeAABB(bounds, objectBounds[objectIndices[i]]);
+        const glm::vec3& c = centers[objectIndices[i]];
+        centerBounds = MergeAABB(centerBounds, AABB(c, c));
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    if (count <= LEAF_SIZE)
+    {
+        nodes[nodeIndex].first = first;
+        nodes[nodeIndex].count = count;
+        return nodeIndex;
+    }
+
+    // 沿包围盒中心分布最长的轴，按中位数把物体分成两半
+    glm::vec3 size = centerBounds.max - centerBounds.min;
+    int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+    int half = count / 2;
+    std::nth_element(objectIndices.begin() + first, objectIndices.begin() + first + half,
+        objectIndices.begin() + first + count,
+        [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+    int left = BuildRecursive(first, half, centers);
+    int right = BuildRecursive(first + half, count - half, centers);
+    nodes[nodeIndex].left = left;
+    nodes[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void BVH::Refit(const std::vector<AABB>& bounds)
+{
+    if (bounds.size() != objectBounds.size())
+    {
+        Build(bounds);
+        return;
+    }
+    objectBounds = bounds;
+    if (!nodes.empty()) RefitRecursive(0);
+}
+
+void BVH::RefitRecursive(int nodeIndex)
+{
+    Node& node = nodes[nodeIndex];
+    if (node.IsLeaf())
+    {
+        node.bounds = objectBounds[objectIndices[node.first]];
+        for (int i = node.first + 1; i < node.first + node.count; ++i)
+            node.bounds = MergeAABB(node.bounds, objectBounds[objectIndices[i]]);
+        return;
+    }
+    RefitRecursive(node.left);
+    RefitRecursive(node.right);
+    // 子节点递归时 nodes 不会重新分配，引用仍然有效
+    node.bounds = MergeAABB(nodes[node.left].bounds, nodes[node.right].bounds);
+}
+
+void BVH::Query(const Frustum& frustum, std::vector<int>& visible) const
+{
+    lastStats = Stats();
+    if (nodes.empty()) return;
+    size_t before = visible.size();
+
+    // 显式栈，避免递归
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        ++lastStats.nodesVisited;
+
+        CullResult result = frustum.TestAABB(node.bounds);
+        if (result == CullResult::Outside) continue;
+        if (result == CullResult::Inside)
+        {
+            CollectAll((int)(&node - nodes.data()), visible);
+            continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            // 叶子里的物体一次 SIMD 测完
+            AABB boxes[LEAF_SIZE];
+            for (int i = 0; i < node.count; ++i)
+                boxes[i] = objectBounds[objectIndices[node.first + i]];
+            unsigned int mask = frustum.TestAABB4(boxes, node.count);
+            lastStats.objectsTested += node.count;
+            for (int i = 0; i < node.count; ++i)
+            {
+                if (mask & (1u << i))
+                    visible.push_back(objectIndices[node.first + i]);
+            }
+            continue;
+        }
+
+        stack[top++] = node.left;
+        stack[top++] = node.right;
+    }
+    lastStats.objectsVisible = (unsigned int)(visible.size() - before);
+}
+
+void BVH::CollectAll(int nodeIndex, std::vector<int>& visible) const
+{
+    const Node& node = nodes[nodeIndex];
+    for (int i = node.first; i < node.first + node.count; ++i)
+        visible.push_back(objectIndices[i]);
+    if (!node.IsLeaf())
+    {
+        CollectAll(node.left, visible);
+        CollectAll(node.right, visible);
+    }
+}
+
+size_t BVH::GetObjectCount() const
+{
+    return objectBounds.size();
+}
+
+const BVH::Stats& BVH::GetLastStats() const
+{
+    return lastStats;
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Collision.h"
+
+/*
+视锥剔除与场景 BVH
+
+Frustum: 从 投影 * 视图 矩阵提取 6 个平面 (法线指向视锥内部)
+    - TestAABB: 单个包围盒，区分 完全在外 / 相交 / 完全在内
+    - TestAABB4: 一次测试 4 个包围盒 (SSE，每个平面只算包围盒最靠内侧的那个角)，返回可能可见的位掩码
+
+BVH: 场景物体世界包围盒上的二叉包围体层次
+    - Build: 按包围盒中心在最长轴上的中位数递归二分，叶子最多 LEAF_SIZE (4) 个物体，正好一次 SIMD 测试
+    - Refit: 物体数量不变、只是变换变了时，自底向上重算节点包围盒，不改变树的结构
+    - Query: 节点完全在视锥外时整棵子树跳过，完全在内时整棵子树直接可见，相交时才往下测
+*/
+
+// 把包围盒变换到另一个空间 (中心 + 半尺寸的写法，结果仍是轴对齐包围盒)
+AABB TransformAABB(const AABB& box, const glm::mat4& matrix);
+// 两个包围盒的并
+AABB MergeAABB(const AABB& a, const AABB& b);
+
+enum class CullResult
+{
+    Outside,    // 完全在视锥外
+    Intersect,  // 与视锥边界相交
+    Inside      // 完全在视锥内
+};
+
+struct Frustum
+{
+    glm::vec4 planes[6];    // dot(plane.xyz, p) + plane.w >= 0 为内侧
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+    CullResult TestAABB(const AABB& box) const;
+    // count <= 4；第 i 位为 1 表示 boxes[i] 可能可见
+    unsigned int TestAABB4(const AABB* boxes, int count) const;
+};
+
+class BVH
+{
+public:
+    static const int LEAF_SIZE = 4;
+
+    // 每次 Query 的统计
+    struct Stats
+    {
+        unsigned int nodesVisited = 0;
+        unsigned int objectsTested = 0;     // 在叶子里逐个 (SIMD) 测试的物体数
+        unsigned int objectsVisible = 0;
+    };
+
+    void Build(const std::vector<AABB>& bounds);
+    // bounds 的数量必须与 Build 时相同
+    void Refit(const std::vector<AABB>& bounds);
+
+    // 把可见物体的下标追加到 visible (顺序与 Build 时的下标无关)
+    void Query(const Frustum& frustum, std::vector<int>& visible) const;
+
+    size_t GetObjectCount() const;
+    const Stats& GetLastStats() const;
+
+private:
+    struct Node
+    {
+        AABB bounds;
+        int left = -1, right = -1;  // 内部节点的两个子节点
+        int first = 0, count = 0;   // 叶子：objectIndices[first, first + count)
+        bool IsLeaf() const { return count > 0; }
+    };
+
+    int BuildRecursive(int first, int count, const std::vector<glm::vec3>& centers);
+    void RefitRecursive(int nodeIndex);
+    void CollectAll(int nodeIndex, std::vector<int>& visible) const;
+
+    std::vector<Node> nodes;
+    std::vector<int> objectIndices;
+    std::vector<AABB> objectBounds;
+    mutable Stats lastStats;
+};
@@ -0,0 +1,139 @@
+﻿#include "FrameGovernor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// 预算系数的下限：再低雪就几乎看不见了
+static const float MIN_BUDGET = 0.1f;
+// 每隔多久评估一次 (秒)，太频繁会在两个档位之间来回抖动
+static const float EVAL_INTERVAL = 0.5f;
+// 帧时间的指数平滑系数 (每帧)
+static const float SMOOTHING = 0.1f;
+// 超过目标 5% 才下调，低于目标 85% 才上调，中间是死区
+static const float OVER_BUDGET_RATIO = 1.05f;
+static const float UNDER_BUDGET_RATIO = 0.85f;
+// 单次下调最多降到原来的 70%；上调每次加 5%
+static const float MAX_DECREASE = 0.7f;
+static const float INCREASE_STEP = 0.05f;
+
+FrameGovernor::FrameGovernor(float targetFps)
+{
+    SetTargetFps(targetFps);
+}
+
+void FrameGovernor::SetTargetFps(float fps)
+{
+    targetMs = 1000.0f / std::max(fps, 1.0f);
+}
+
+float FrameGovernor::GetTargetFps() const
+{
+    return 1000.0f / targetMs;
+}
+
+void FrameGovernor::SetEnabled(bool e)
+{
+    enabled = e;
+    if (!enabled) budgetScale = 1.0f;
+}
+
+bool FrameGovernor::IsEnabled() const
+{
+    return enabled;
+}
+
+float FrameGovernor::GetBudgetScale() const
+{
+    return budgetScale;
+}
+
+float FrameGovernor::GetCpuMs() const
+{
+    return cpuMs;
+}
+
+float FrameGovernor::GetGpuMs() const
+{
+    return gpuMs;
+}
+
+void FrameGovernor::BeginFrame()
+{
+    // 查询对象在第一次使用时创建 (构造时可能还没有 GL 上下文)
+    if (queries[0] == 0)
+        glGenQueries(QUERY_COUNT, queries);
+
+    ReadGpuQueries();
+
+    // 环形中下一个查询的结果还没回来 (GPU 落后太多) 时跳过本帧的 GPU 计时，不去等它
+    if (!queryPending[queryIndex])
+    {
+        glBeginQuery(GL_TIME_ELAPSED, queries[queryIndex]);
+        inFrame = true;
+    }
+    // 两次 BeginFrame 之间是完整的一帧 (含 SwapBuffers)，用来决定多久评估一次
+    auto now = std::chrono::steady_clock::now();
+    if (started) evalTimer += std::chrono::duration<float>(now - frameStart).count();
+    frameStart = now;
+    started = true;
+}
+
+void FrameGovernor::EndFrame()
+{
+    float frameCpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    cpuMs += (frameCpuMs - cpuMs) * SMOOTHING;
+
+    if (inFrame)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryPending[queryIndex] = true;
+        queryIndex = (queryIndex + 1) % QUERY_COUNT;
+        inFrame = false;
+    }
+
+    if (evalTimer >= EVAL_INTERVAL)
+    {
+        evalTimer = 0.0f;
+        Evaluate();
+    }
+}
+
+// 只读取已经完成的查询，按提交顺序处理
+void FrameGovernor::ReadGpuQueries()
+{
+    for (int k = 0; k < QUERY_COUNT; ++k)
+    {
+        int i = (queryIndex + k) % QUERY_COUNT;
+        if (!queryPending[i]) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &ns);
+        queryPending[i] = false;
+        gpuMs += ((float)ns * 1e-6f - gpuMs) * SMOOTHING;
+    }
+}
+
+void FrameGovernor::Evaluate()
+{
+    if (!enabled) return;
+
+    float frameMs = std::max(cpuMs, gpuMs);
+    float ratio = frameMs / targetMs;
+    float oldScale = budgetScale;
+
+    if (ratio > OVER_BUDGET_RATIO)
+        budgetScale *= std::max(1.0f / ratio, MAX_DECREASE);
+    else if (ratio < UNDER_BUDGET_RATIO)
+        budgetScale += INCREASE_STEP;
+    budgetScale = std::min(std::max(budgetScale, MIN_BUDGET), 1.0f);
+
+    if (budgetScale != oldScale)
+    {
+        printf("FrameGovernor: cpu %.1f ms, gpu %.1f ms (target %.1f ms) -> particle budget %.0f%%\n",
+            cpuMs, gpuMs, targetMs, budgetScale * 100.0f);
+    }
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <chrono>
+
+/*
+ * FrameGovernor: 帧时间调节器
+ *
+ * 每帧测量 CPU 时间 (BeginFrame 到 EndFrame 之间的墙钟时间，不含 SwapBuffers 的等待)
+ * 和 GPU 时间 (GL_TIME_ELAPSED 查询，环形使用几个查询对象，只读取已经完成的结果，不会让 CPU 等 GPU)，
+ * 取两者较大者做指数平滑，每隔 EVAL_INTERVAL 秒和目标帧时间比较一次，调整"预算系数" (MIN_BUDGET ~ 1)：
+ *   - 超出目标：按超出的比例乘性下调 (一次最多降到 70%)，尽快把帧率拉回来
+ *   - 明显低于目标：每次加性上调一小步，慢慢试探机器还能负担多少
+ * 调用方 (SnowScene::SetBudgetScale) 用这个系数缩放雪花的生成速率、粒子数上限和真实粒子的范围，
+ * 天气预设 (小雪/中雪/大雪) 只表达"想要多大的雪"，实际能画多少由调节器决定。
+ *
+ * 使用方法：
+ *   frameGovernor.BeginFrame();                 // 每帧开始
+ *   snowyScene.SetBudgetScale(frameGovernor.GetBudgetScale());
+ *   ... 更新与绘制 ...
+ *   frameGovernor.EndFrame();                   // SwapBuffers 之前
+ */
+class FrameGovernor
+{
+public:
+    FrameGovernor(float targetFps = 60.0f);
+
+    void SetTargetFps(float fps);
+    float GetTargetFps() const;
+
+    // 关闭时预算系数固定为 1 (仍然会测量帧时间)
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    void BeginFrame();
+    void EndFrame();
+
+    // 当前的预算系数 (MIN_BUDGET ~ 1)
+    float GetBudgetScale() const;
+    // 平滑后的 CPU / GPU 帧时间 (毫秒)，GPU 时间不可用时为 0
+    float GetCpuMs() const;
+    float GetGpuMs() const;
+
+private:
+    void ReadGpuQueries();
+    void Evaluate();
+
+    static const int QUERY_COUNT = 4;   // GPU 结果一般晚 1~2 帧才可用
+
+    float targetMs;
+    bool enabled = true;
+    float budgetScale = 1.0f;
+
+    std::chrono::steady_clock::time_point frameStart;
+    bool started = false;
+    float cpuMs = 0.0f;
+    float gpuMs = 0.0f;
+    float evalTimer = 0.0f;             // 距离上次调整的时间 (秒)
+
+    // 查询对象随 GL 上下文一起释放 (全局对象析构时上下文可能已经销毁)
+    unsigned int queries[QUERY_COUNT] = { 0 };
+    bool queryPending[QUERY_COUNT] = { false };
+    int queryIndex = 0;
+    bool inFrame = false;
+};
@@ -0,0 +1,340 @@
+﻿#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// 递归下降解析器 (嵌套深度有上限，防止损坏的文件把栈耗尽)
+class JsonParser
+{
+public:
+    JsonParser(const char* text, size_t length) : current(text), begin(text), end(text + length) {}
+
+    bool ParseDocument(JsonValue& result)
+    {
+        SkipWhitespace();
+        if (!ParseValue(result, 0)) return false;
+        SkipWhitespace();
+        return current == end || Fail("trailing characters");
+    }
+
+    std::string error;
+    size_t errorOffset = 0;
+
+private:
+    static const int MAX_DEPTH = 256;
+
+    const char* current;
+    const char* begin;
+    const char* end;
+
+    bool Fail(const char* message)
+    {
+        if (error.empty())
+        {
+            error = message;
+            errorOffset = (size_t)(current - begin);
+        }
+        return false;
+    }
+
+    void SkipWhitespace()
+    {
+        while (current < end && (*current == ' ' || *current == '\t' || *current == '\n' || *current == '\r'))
+            ++current;
+    }
+
+    bool Match(const char* literal)
+    {
+        size_t length = std::strlen(literal);
+        if ((size_t)(end - current) < length || std::memcmp(current, literal, length) != 0)
+            return false;
+        current += length;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& value, int depth)
+    {
+        if (depth > MAX_DEPTH) return Fail("nesting too deep");
+        if (current >= end) return Fail("unexpected end of input");
+
+        switch (*current)
+        {
+        case '{': return ParseObject(value, depth);
+        case '[': return ParseArray(value, depth);
+        case '"':
+            value.type = JsonValue::Type::String;
+            return ParseString(value.string);
+        case 't':
+            if (!Match("true")) return Fail("invalid literal");
+            value.type = JsonValue::Type::Bool;
+            value.boolean = true;
+            return true;
+        case 'f':
+            if (!Match("false")) return Fail("invalid literal");
+            value.type = JsonValue::Type::Bool;
+            value.boolean = false;
+            return true;
+        case 'n':
+            if (!Match("null")) return Fail("invalid literal");
+            value.type = JsonValue::Type::Null;
+            return true;
+        default:
+            return ParseNumber(value);
+        }
+    }
+
+    bool ParseObject(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::Type::Object;
+        ++current; // '{'
+        SkipWhitespace();
+        if (current < end && *current == '}')
+        {
+            ++current;
+            return true;
+        }
+        while (true)
+        {
+            SkipWhitespace();
+            if (current >= end || *current != '"') return Fail("expected member name");
+            value.members.emplace_back();
+            if (!ParseString(value.members.back().first)) return false;
+            SkipWhitespace();
+            if (current >= end || *current != ':') return Fail("expected ':'");
+            ++current;
+            SkipWhitespace();
+            if (!ParseValue(value.members.back().second, depth + 1)) return false;
+            SkipWhitespace();
+            if (current < end && *current == ',')
+            {
+                ++current;
+                continue;
+            }
+            if (current < end && *current == '}')
+            {
+                ++current;
+                return true;
+            }
+            return Fail("expected ',' or '}'");
+        }
+    }
+
+    bool ParseArray(JsonValue& value, int depth)
+    {
+        value.type = JsonValue::Type::Array;
+        ++current; // '['
+        SkipWhitespace();
+        if (current < end && *current == ']')
+        {
+            ++current;
+            return true;
+        }
+        while (true)
+        {
+            SkipWhitespace();
+            value.elements.emplace_back();
+            if (!ParseValue(value.elements.back(), depth + 1)) return false;
+            SkipWhitespace();
+            if (current < end && *current == ',')
+            {
+                ++current;
+                continue;
+            }
+            if (current < end && *current == ']')
+            {
+                ++current;
+                return true;
+            }
+            return Fail("expected ',' or ']'");
+        }
+    }
+
+    bool ParseHex4(unsigned int& code)
+    {
+        if (end - current < 4) return Fail("invalid unicode escape");
+        code = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            char c = *current++;
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= (unsigned int)(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= (unsigned int)(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= (unsigned int)(c - 'A' + 10);
+            else return Fail("invalid unicode escape");
+        }
+        return true;
+    }
+
+    static void AppendUtf8(std::string& out, unsigned int code)
+    {
+        if (code < 0x80)
+        {
+            out += (char)code;
+        }
+        else if (code < 0x800)
+        {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool ParseString(std::string& out)
+    {
+        ++current; // '"'
+        while (true)
+        {
+            // 连续的普通字符一次追加
+            const char* run = current;
+            while (current < end && *current != '"' && *current != '\\')
+                ++current;
+            out.append(run, current);
+            if (current >= end) return Fail("unterminated string");
+
+            if (*current == '"')
+            {
+                ++current;
+                return true;
+            }
+
+            ++current; // '\\'
+            if (current >= end) return Fail("unterminated string");
+            char escape = *current++;
+            switch (escape)
+            {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                unsigned int code;
+                if (!ParseHex4(code)) return false;
+                // 代理对 (BMP 以外的字符)
+                if (code >= 0xD800 && code <= 0xDBFF && end - current >= 6 && current[0] == '\\' && current[1] == 'u')
+                {
+                    current += 2;
+                    unsigned int low;
+                    if (!ParseHex4(low)) return false;
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(out, code);
+                break;
+            }
+            default:
+                return Fail("invalid escape");
+            }
+        }
+    }
+
+    bool ParseNumber(JsonValue& value)
+    {
+        // strtod 需要以 '\0' 结尾的文本，数字很短，先拷贝出来
+        const char* start = current;
+        while (current < end && (std::strchr("+-0123456789.eE", *current) != nullptr))
+            ++current;
+        if (current == start) return Fail("unexpected character");
+
+        char buffer[64];
+        size_t length = (size_t)(current - start);
+        if (length >= sizeof(buffer)) return Fail("number too long");
+        std::memcpy(buffer, start, length);
+        buffer[length] = '\0';
+
+        char* parsedEnd = nullptr;
+        value.number = std::strtod(buffer, &parsedEnd);
+        if (parsedEnd != buffer + length)
+        {
+            current = start;
+            return Fail("invalid number");
+        }
+        value.type = JsonValue::Type::Number;
+        return true;
+    }
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& result, std::string* error)
+{
+    result = JsonValue();
+    JsonParser parser(text, length);
+    if (parser.ParseDocument(result)) return true;
+    if (error)
+        *error = parser.error + " at offset " + std::to_string(parser.errorOffset);
+    result = JsonValue();
+    return false;
+}
+
+const JsonValue* JsonValue::Find(const std::string& key) const
+{
+    for (const auto& member : members)
+    {
+        if (member.first == key)
+            return &member.second;
+    }
+    return nullptr;
+}
+
+size_t JsonValue::Size() const
+{
+    return elements.size();
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return elements[index];
+}
+
+bool JsonValue::AsBool(bool fallback) const
+{
+    return type == Type::Bool ? boolean : fallback;
+}
+
+double JsonValue::AsNumber(double fallback) const
+{
+    return type == Type::Number ? number : fallback;
+}
+
+int JsonValue::AsInt(int fallback) const
+{
+    return type == Type::Number ? (int)number : fallback;
+}
+
+const std::string& JsonValue::AsString() const
+{
+    return string;
+}
+
+int JsonValue::GetInt(const std::string& key, int fallback) const
+{
+    const JsonValue* value = Find(key);
+    return value ? value->AsInt(fallback) : fallback;
+}
+
+double JsonValue::GetNumber(const std::string& key, double fallback) const
+{
+    const JsonValue* value = Find(key);
+    return value ? value->AsNumber(fallback) : fallback;
+}
+
+std::string JsonValue::GetString(const std::string& key, const std::string& fallback) const
+{
+    const JsonValue* value = Find(key);
+    return value && value->IsString() ? value->string : fallback;
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+JsonValue: 最小的 JSON 解析 (只读 DOM)
+
+只为读取 glTF 这类资源描述文件：整个文本一次解析成树，按键名/下标访问，不支持修改和写出。
+对象的成员按文件中的顺序保存，查找是线性的 (资源文件里每个对象只有几个键)。
+取值函数在类型不符或键不存在时返回调用方给的默认值，调用方不用逐级判断。
+*/
+class JsonValue
+{
+public:
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    // 解析整个文本，失败时返回 false 并在 error 里写出位置
+    static bool Parse(const char* text, size_t length, JsonValue& result, std::string* error = nullptr);
+
+    Type GetType() const { return type; }
+    bool IsNull() const { return type == Type::Null; }
+    bool IsNumber() const { return type == Type::Number; }
+    bool IsString() const { return type == Type::String; }
+    bool IsArray() const { return type == Type::Array; }
+    bool IsObject() const { return type == Type::Object; }
+
+    // 对象成员，不存在 (或不是对象) 时返回 nullptr
+    const JsonValue* Find(const std::string& key) const;
+    // 数组元素个数 (不是数组时为 0)
+    size_t Size() const;
+    const JsonValue& operator[](size_t index) const;
+
+    bool AsBool(bool fallback = false) const;
+    double AsNumber(double fallback = 0.0) const;
+    int AsInt(int fallback = 0) const;
+    const std::string& AsString() const;
+
+    // 成员的便捷取值：键不存在或类型不符时返回默认值
+    int GetInt(const std::string& key, int fallback = 0) const;
+    double GetNumber(const std::string& key, double fallback = 0.0) const;
+    std::string GetString(const std::string& key, const std::string& fallback = std::string()) const;
+
+private:
+    friend class JsonParser;
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+};
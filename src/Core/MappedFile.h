@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+MappedFile: 只读的内存映射文件
+
+整个文件映射进地址空间，读取时由操作系统按页从磁盘 (或页缓存) 调入，不需要先拷贝到自己的缓冲里。
+映射在 Close 或析构时解除，之后 GetData 返回的指针失效。
+*/
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 打开并映射整个文件，失败 (文件不存在、空文件) 时返回 false
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const;
+    const unsigned char* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,347 @@
+﻿#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+// x64 上 SSE 总是可用；其他平台退回标量实现
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+// 包围盒的 12 个三角形 (角点编号：第 0/1/2 位分别表示取 max.x/max.y/max.z)，绕序无所谓，光栅化时统一
+static const int BOX_TRIANGLES[12][3] = {
+    { 0, 2, 6 }, { 0, 6, 4 },   // -x
+    { 1, 3, 7 }, { 1, 7, 5 },   // +x
+    { 0, 1, 5 }, { 0, 5, 4 },   // -y
+    { 2, 3, 7 }, { 2, 7, 6 },   // +y
+    { 0, 1, 3 }, { 0, 3, 2 },   // -z
+    { 4, 5, 7 }, { 4, 7, 6 }    // +z
+};
+
+static glm::vec3 BoxCorner(const AABB& box, int index)
+{
+    return glm::vec3((index & 1) ? box.max.x : box.min.x,
+        (index & 2) ? box.max.y : box.min.y,
+        (index & 4) ? box.max.z : box.min.z);
+}
+
+// 裁剪空间 -> 深度缓冲的像素坐标 (x, y) 与 NDC 深度 (z)
+static glm::vec3 ToScreen(const glm::vec4& clip)
+{
+    float invW = 1.0f / clip.w;
+    return glm::vec3((clip.x * invW * 0.5f + 0.5f) * (float)OcclusionCuller::WIDTH,
+        (clip.y * invW * 0.5f + 0.5f) * (float)OcclusionCuller::HEIGHT,
+        clip.z * invW);
+}
+
+OcclusionCuller::OcclusionCuller()
+    : depthBuffer(WIDTH * HEIGHT, FLT_MAX)
+{
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    Stop();
+}
+
+void OcclusionCuller::SetOccluders(const std::vector<AABB>& boxes)
+{
+    Wait();
+    occluders = boxes;
+}
+
+void OcclusionCuller::Start()
+{
+    if (running) return;
+    quit = false;
+    running = true;
+    worker = std::thread(&OcclusionCuller::WorkerLoop, this);
+}
+
+void OcclusionCuller::Stop()
+{
+    if (!running) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    condition.notify_all();
+    worker.join();
+    running = false;
+    jobPending = false;
+}
+
+void OcclusionCuller::SetEnabled(bool value)
+{
+    enabled = value;
+}
+
+bool OcclusionCuller::IsEnabled() const
+{
+    return enabled;
+}
+
+void OcclusionCuller::Submit(const glm::mat4& viewProjection, const std::vector<AABB>& objectBounds)
+{
+    // 上一个任务还在用输入输出缓冲，先等它结束
+    Wait();
+
+    if (!enabled)
+    {
+        occluded.assign(objectBounds.size(), 0);
+        lastStats = Stats();
+        return;
+    }
+
+    jobViewProjection = viewProjection;
+    jobBounds = objectBounds;
+    if (!running)
+    {
+        Run();
+        lastStats = jobStats;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobPending = true;
+    }
+    condition.notify_all();
+}
+
+void OcclusionCuller::Wait()
+{
+    if (!running) return;
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return !jobPending && !jobBusy; });
+    lastStats = jobStats;
+}
+
+bool OcclusionCuller::IsOccluded(int index) const
+{
+    return index >= 0 && index < (int)occluded.size() && occluded[index] != 0;
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::GetLastStats() const
+{
+    return lastStats;
+}
+
+const std::vector<float>& OcclusionCuller::GetDepthBuffer() const
+{
+    return depthBuffer;
+}
+
+void OcclusionCuller::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this] { return jobPending || quit; });
+        if (quit) return;
+        jobPending = false;
+        jobBusy = true;
+
+        lock.unlock();
+        Run();
+        lock.lock();
+
+        jobBusy = false;
+        condition.notify_all();
+    }
+}
+
+void OcclusionCuller::Run()
+{
+    auto start = std::chrono::steady_clock::now();
+    jobStats = Stats();
+
+    std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+    for (const auto& box : occluders)
+        RasterizeBox(box, jobViewProjection);
+
+    occluded.assign(jobBounds.size(), 0);
+    for (size_t i = 0; i < jobBounds.size(); ++i)
+    {
+        // 与遮挡物重叠的物体 (通常就是遮挡物所代表的模型本身) 不能用它来判断，直接视为可见
+        bool overlaps = false;
+        for (const auto& box : occluders)
+            overlaps |= box.checkCollision(jobBounds[i]);
+        if (overlaps) continue;
+
+        ++jobStats.tested;
+        if (!TestBox(jobBounds[i], jobViewProjection))
+        {
+            occluded[i] = 1;
+            ++jobStats.occluded;
+        }
+    }
+
+    jobStats.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::RasterizeBox(const AABB& box, const glm::mat4& viewProjection)
+{
+    glm::vec4 clip[8];
+    bool anyInFront = false;
+    for (int i = 0; i < 8; ++i)
+    {
+        clip[i] = viewProjection * glm::vec4(BoxCorner(box, i), 1.0f);
+        anyInFront |= clip[i].z >= -clip[i].w;
+    }
+    if (!anyInFront) return;
+
+    unsigned int trianglesBefore = jobStats.triangles;
+    for (const auto& triangle : BOX_TRIANGLES)
+    {
+        // 对近平面 (z + w >= 0) 裁剪，三角形最多变成四边形
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            const glm::vec4& current = clip[triangle[k]];
+            const glm::vec4& next = clip[triangle[(k + 1) % 3]];
+            float dCurrent = current.z + current.w;
+            float dNext = next.z + next.w;
+            if (dCurrent >= 0.0f)
+                polygon[count++] = current;
+            if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+                polygon[count++] = current + (next - current) * (dCurrent / (dCurrent - dNext));
+        }
+        if (count < 3) continue;
+
+        glm::vec3 screen[4];
+        for (int k = 0; k < count; ++k)
+            screen[k] = ToScreen(polygon[k]);
+        for (int k = 1; k + 1 < count; ++k)
+            RasterizeTriangle(screen[0], screen[k], screen[k + 1]);
+    }
+    if (jobStats.triangles != trianglesBefore)
+        ++jobStats.occluders;
+}
+
+void OcclusionCuller::RasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    // 边函数 edge(u, v, p) = A * p.x + B * p.y + C，三个都 >= 0 时像素中心在三角形内
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (std::abs(area) < 1e-8f) return;
+    const glm::vec3& v1 = area > 0.0f ? b : c;
+    const glm::vec3& v2 = area > 0.0f ? c : b;
+    area = std::abs(area);
+
+    int x0 = std::max(0, (int)std::floor(std::min(a.x, std::min(v1.x, v2.x))));
+    int x1 = std::min(WIDTH - 1, (int)std::ceil(std::max(a.x, std::max(v1.x, v2.x))));
+    int y0 = std::max(0, (int)std::floor(std::min(a.y, std::min(v1.y, v2.y))));
+    int y1 = std::min(HEIGHT - 1, (int)std::ceil(std::max(a.y, std::max(v1.y, v2.y))));
+    if (x0 > x1 || y0 > y1) return;
+    x0 &= ~3;   // 按 4 个像素对齐
+    ++jobStats.triangles;
+
+    float A0 = v1.y - v2.y, B0 = v2.x - v1.x, C0 = -(A0 * v1.x + B0 * v1.y);  // edge(v1, v2)，对应顶点 a 的权重
+    float A1 = v2.y - a.y, B1 = a.x - v2.x, C1 = -(A1 * v2.x + B1 * v2.y);    // edge(v2, a)，对应 v1
+    float A2 = a.y - v1.y, B2 = v1.x - a.x, C2 = -(A2 * a.x + B2 * a.y);      // edge(a, v1)，对应 v2
+
+    // NDC 深度在屏幕空间里是线性的：z = Zx * x + Zy * y + Zc
+    float invArea = 1.0f / area;
+    float Zx = (A0 * a.z + A1 * v1.z + A2 * v2.z) * invArea;
+    float Zy = (B0 * a.z + B1 * v1.z + B2 * v2.z) * invArea;
+    float Zc = (C0 * a.z + C1 * v1.z + C2 * v2.z) * invArea;
+
+#ifdef OCCLUSION_USE_SSE
+    const __m128 laneOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = (float)y + 0.5f;
+        __m128 rowE0 = _mm_set1_ps(B0 * py + C0);
+        __m128 rowE1 = _mm_set1_ps(B1 * py + C1);
+        __m128 rowE2 = _mm_set1_ps(B2 * py + C2);
+        __m128 rowZ = _mm_set1_ps(Zy * py + Zc);
+        float* row = &depthBuffer[y * WIDTH];
+        for (int x = x0; x <= x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffset);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0), px), rowE0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A1), px), rowE1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A2), px), rowE2);
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+            if (_mm_movemask_ps(inside) == 0) continue;
+
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(Zx), px), rowZ);
+            __m128 old = _mm_loadu_ps(row + x);
+            __m128 write = _mm_and_ps(inside, _mm_cmplt_ps(z, old));
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(write, z), _mm_andnot_ps(write, old)));
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = (float)y + 0.5f;
+        float* row = &depthBuffer[y * WIDTH];
+        for (int x = x0; x <= x1; ++x)
+        {
+            float px = (float)x + 0.5f;
+            if (A0 * px + B0 * py + C0 < 0.0f || A1 * px + B1 * py + C1 < 0.0f || A2 * px + B2 * py + C2 < 0.0f)
+                continue;
+            float z = Zx * px + Zy * py + Zc;
+            if (z < row[x]) row[x] = z;
+        }
+    }
+#endif
+}
+
+bool OcclusionCuller::TestBox(const AABB& box, const glm::mat4& viewProjection) const
+{
+    glm::vec2 ndcMin(FLT_MAX), ndcMax(-FLT_MAX);
+    float nearestZ = FLT_MAX;
+    for (int i = 0; i < 8; ++i)
+    {
+        glm::vec4 clip = viewProjection * glm::vec4(BoxCorner(box, i), 1.0f);
+        // 有角点在近平面前面：包围盒离相机太近 (或在相机后面)，不做判断
+        if (clip.z < -clip.w || clip.w <= 1e-6f) return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        ndcMin = glm::min(ndcMin, glm::vec2(ndc));
+        ndcMax = glm::max(ndcMax, glm::vec2(ndc));
+        nearestZ = std::min(nearestZ, ndc.z);
+    }
+
+    // 覆盖到的像素 (与矩形有任何重叠的都算)，完全在屏幕外的交给视锥剔除
+    float sx0 = (ndcMin.x * 0.5f + 0.5f) * (float)WIDTH, sx1 = (ndcMax.x * 0.5f + 0.5f) * (float)WIDTH;
+    float sy0 = (ndcMin.y * 0.5f + 0.5f) * (float)HEIGHT, sy1 = (ndcMax.y * 0.5f + 0.5f) * (float)HEIGHT;
+    if (sx1 < 0.0f || sy1 < 0.0f || sx0 >= (float)WIDTH || sy0 >= (float)HEIGHT) return true;
+    int x0 = std::max(0, (int)std::floor(sx0));
+    int x1 = std::min(WIDTH - 1, (int)std::floor(sx1));
+    int y0 = std::max(0, (int)std::floor(sy0));
+    int y1 = std::min(HEIGHT - 1, (int)std::floor(sy1));
+
+    // 只要有一个像素的遮挡深度不比包围盒最近的点更近，就可能看得见
+#ifdef OCCLUSION_USE_SSE
+    const __m128 laneIndex = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 first = _mm_set1_ps((float)x0), last = _mm_set1_ps((float)x1);
+    __m128 nearest = _mm_set1_ps(nearestZ);
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = &depthBuffer[y * WIDTH];
+        for (int x = x0 & ~3; x <= x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneIndex);
+            __m128 lanes = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+            __m128 visible = _mm_and_ps(lanes, _mm_cmpge_ps(_mm_loadu_ps(row + x), nearest));
+            if (_mm_movemask_ps(visible) != 0) return true;
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y)
+    {
+        const float* row = &depthBuffer[y * WIDTH];
+        for (int x = x0; x <= x1; ++x)
+        {
+            if (row[x] >= nearestZ) return true;
+        }
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Collision.h"
+
+/*
+OcclusionCuller: CPU 软件遮挡剔除
+
+几个大的遮挡物 (房子、集装箱、巴士的碰撞盒，向内收缩一些，保证不会比真实模型更大) 用 SSE 光栅化器
+画进一张 WIDTH × HEIGHT 的低分辨率深度缓冲 (NDC 深度，每个像素取最近值)，然后把每个物体的世界包围盒
+投影到屏幕上，包围盒覆盖的所有像素都比它最近的深度更近时，这个物体完全被挡住，主 Pass 不画它。
+
+    - 光栅化：三角形先在裁剪空间对近平面裁剪，再用边函数一次算 4 个像素 (像素中心在三角形内才写入)
+    - 测试：包围盒跨过近平面 (相机在盒子附近) 或与某个遮挡物重叠 (比如遮挡物对应的模型本身) 时直接视为可见；
+      否则取屏幕矩形与最近深度，一次比较 4 个像素
+    - 线程：Start 之后光栅化与测试在工作线程上进行。主线程在帧开始算出相机矩阵后 Submit，
+      接着做粒子更新、阴影等 CPU 工作 (GPU 此时还在画上一帧)，到主 Pass 绘制前才 Wait 取结果。
+      没有 Start 时 Submit 直接同步执行
+
+使用方法：
+    occlusionCuller.SetOccluders(boxes);
+    occlusionCuller.Start();
+    每帧: occlusionCuller.Submit(projection * view, objectBounds);
+          ... 其它工作 ...
+          occlusionCuller.Wait();
+          if (occlusionCuller.IsOccluded(i)) 跳过第 i 个物体
+*/
+class OcclusionCuller
+{
+public:
+    static const int WIDTH = 256;   // 必须是 4 的倍数
+    static const int HEIGHT = 128;
+
+    // 每次 Submit 的统计
+    struct Stats
+    {
+        unsigned int occluders = 0;     // 画进深度缓冲的遮挡物数 (在近平面后面或屏幕外的不算)
+        unsigned int triangles = 0;     // 光栅化的三角形数 (近平面裁剪之后)
+        unsigned int tested = 0;        // 实际做深度测试的物体数 (不含与遮挡物重叠的)
+        unsigned int occluded = 0;
+        float milliseconds = 0.0f;      // 工作线程上光栅化 + 测试的耗时
+    };
+
+    OcclusionCuller();
+    ~OcclusionCuller();
+
+    // 遮挡物 (世界空间包围盒)，在 Start 之前设置
+    void SetOccluders(const std::vector<AABB>& boxes);
+
+    // 启动 / 停止工作线程 (Stop 会等待当前任务完成)
+    void Start();
+    void Stop();
+
+    // 关闭时 Submit 不做任何工作，所有物体都视为可见
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    // 提交本帧的任务：viewProjection 为主相机的 投影 * 视图，objectBounds 为要测试的物体世界包围盒
+    void Submit(const glm::mat4& viewProjection, const std::vector<AABB>& objectBounds);
+    // 等待最近一次 Submit 的任务完成
+    void Wait();
+
+    // Wait 之后：第 index 个物体是否被完全遮挡
+    bool IsOccluded(int index) const;
+    // Wait 之后：最近一次任务的统计
+    const Stats& GetLastStats() const;
+    // Wait 之后：深度缓冲 (WIDTH * HEIGHT，行从屏幕下方开始，调试用)
+    const std::vector<float>& GetDepthBuffer() const;
+
+private:
+    void WorkerLoop();
+    void Run();
+
+    void RasterizeBox(const AABB& box, const glm::mat4& viewProjection);
+    void RasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+    bool TestBox(const AABB& box, const glm::mat4& viewProjection) const;
+
+    std::vector<AABB> occluders;
+    bool enabled = true;
+
+    // 任务的输入与输出 (工作线程运行期间只由它访问)
+    glm::mat4 jobViewProjection = glm::mat4(1.0f);
+    std::vector<AABB> jobBounds;
+    std::vector<unsigned char> occluded;
+    std::vector<float> depthBuffer;
+    Stats jobStats;
+    Stats lastStats;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running = false;
+    bool jobPending = false;    // 已提交、工作线程还没取走
+    bool jobBusy = false;       // 工作线程正在执行
+    bool quit = false;
+};
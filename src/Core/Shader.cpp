@@ -83,25 +83,64 @@ void Shader::use()
     glUseProgram(ID);
 }
 
+GLint Shader::getLocation(const std::string& name) const
+{
+    auto it = uniformLocations.find(name);
+    if (it != uniformLocations.end())
+        return it->second;
+    GLint location = glGetUniformLocation(ID, name.c_str());
+    uniformLocations.emplace(name, location);
+    return location;
+}
+
+void Shader::set(Uniform<bool> uniform, bool value) const
+{
+    glUniform1i(uniform.location, (int)value);
+}
+void Shader::set(Uniform<int> uniform, int value) const
+{
+    glUniform1i(uniform.location, value);
+}
+void Shader::set(Uniform<float> uniform, float value) const
+{
+    glUniform1f(uniform.location, value);
+}
+void Shader::set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::set(Uniform<glm::vec2> uniform, const glm::vec2& value) const
+{
+    glUniform2fv(uniform.location, 1, &value[0]);
+}
+void Shader::set(Uniform<glm::vec3> uniform, const glm::vec3& value) const
+{
+    glUniform3fv(uniform.location, 1, &value[0]);
+}
+
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(getLocation(name), (int)value);
 }
 void Shader::setInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(getLocation(name), value);
 }
 void Shader::setFloat(const std::string& name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(getLocation(name), value);
 }
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(getLocation(name), 1, GL_FALSE, &mat[0][0]);
+}
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const
+{
+    glUniform2fv(getLocation(name), 1, &value[0]);
 }
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    glUniform3fv(getLocation(name), 1, &value[0]);
 }
 
 void Shader::checkCompileErrors(unsigned int shader, std::string type)
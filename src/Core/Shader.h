@@ -4,10 +4,19 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// 预先解析好的 uniform 位置 (Shader::getUniform)，类型决定能用哪个 set 重载
+// 帧循环里用它设置 uniform，不再构造名字字符串、也不再查位置；程序里没有的 uniform 位置为 -1，设置时被 GL 忽略
+template <typename T>
+struct Uniform
+{
+    GLint location = -1;
+};
+
 class Shader
 {
 public:
@@ -19,14 +28,34 @@ public:
     // 激活着色器
     void use();
 
-    // uniform 工具函数 (后续传参用)
+    // 查找 uniform 位置：每个名字只调用一次 glGetUniformLocation，之后从缓存里取
+    GLint getLocation(const std::string& name) const;
+    template <typename T>
+    Uniform<T> getUniform(const std::string& name) const
+    {
+        return Uniform<T>{ getLocation(name) };
+    }
+
+    // 用预先解析好的位置设置 uniform (需要先 use)
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<int> uniform, int value) const;
+    void set(Uniform<float> uniform, float value) const;
+    void set(Uniform<glm::mat4> uniform, const glm::mat4& mat) const;
+    void set(Uniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+
+    // uniform 工具函数 (按名字设置，位置经过缓存；适合初始化时的一次性设置)
     void setBool(const std::string& name, bool value) const;
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+    void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
 
 private:
     // 检查编译错误的辅助函数
     void checkCompileErrors(unsigned int shader, std::string type);
+
+    // 名字 -> uniform 位置
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
 };
\ No newline at end of file
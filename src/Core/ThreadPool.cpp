@@ -0,0 +1,68 @@
+﻿#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+void ThreadPool::Start(int threadCount)
+{
+    if (!workers.empty()) return;
+    if (threadCount <= 0)
+        threadCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+
+    quit = false;
+    for (int i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+void ThreadPool::Stop()
+{
+    if (workers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        tasks.clear();
+    }
+    condition.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    if (workers.empty())
+    {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+int ThreadPool::GetThreadCount() const
+{
+    return (int)workers.size();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        condition.wait(lock, [this] { return !tasks.empty() || quit; });
+        if (quit) return;
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
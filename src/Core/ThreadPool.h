@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ThreadPool: 固定数量工作线程的任务队列
+
+任务按提交顺序取出，由任意一个空闲的工作线程执行；任务之间的依赖由任务自己处理
+(比如最后一个完成的任务再提交后续工作)。没有 Start 时 Enqueue 直接在调用线程上同步执行。
+Stop 会丢弃还没开始的任务并等待正在执行的任务结束。
+*/
+class ThreadPool
+{
+public:
+    ~ThreadPool();
+
+    // threadCount <= 0 时取 硬件线程数 - 1 (至少 1 个，主线程留给渲染)
+    void Start(int threadCount = 0);
+    void Stop();
+
+    void Enqueue(std::function<void()> task);
+
+    int GetThreadCount() const;
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool quit = false;
+};
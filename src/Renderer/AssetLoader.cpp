@@ -0,0 +1,196 @@
+﻿#include "AssetLoader.h"
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+void DecodedImage::PixelDeleter::operator()(unsigned char* pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+AssetLoader& AssetLoader::Get()
+{
+    static AssetLoader loader;
+    return loader;
+}
+
+void AssetLoader::Start(int workerThreads)
+{
+    cancelled = false;
+    pool.Start(workerThreads);
+}
+
+void AssetLoader::Stop()
+{
+    cancelled = true;
+    pool.Stop();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        mainThreadJobs.clear();
+    }
+    if (pixelBuffers[0] != 0)
+    {
+        glDeleteBuffers(PBO_COUNT, pixelBuffers);
+        for (auto& buffer : pixelBuffers)
+            buffer = 0;
+    }
+}
+
+bool AssetLoader::IsCancelled() const
+{
+    return cancelled;
+}
+
+void AssetLoader::RunAsync(std::function<void()> job)
+{
+    pool.Enqueue(std::move(job));
+}
+
+void AssetLoader::RunOnMainThread(std::function<void()> job)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    mainThreadJobs.push_back(std::move(job));
+}
+
+void AssetLoader::Update(double budgetMilliseconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (mainThreadJobs.empty()) return;
+            job = std::move(mainThreadJobs.front());
+            mainThreadJobs.pop_front();
+        }
+        // 任务里可能再排队新的任务，执行时不持有锁
+        job();
+
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed >= budgetMilliseconds) return;
+    }
+}
+
+void AssetLoader::BeginAsset()
+{
+    ++pendingAssets;
+}
+
+void AssetLoader::EndAsset()
+{
+    --pendingAssets;
+    ++completedAssets;
+}
+
+int AssetLoader::GetPendingAssets() const
+{
+    return pendingAssets;
+}
+
+unsigned int AssetLoader::GetCompletedAssets() const
+{
+    return completedAssets;
+}
+
+void AssetLoader::DecodeImage(const std::string& filename, DecodedImage& image)
+{
+    // 翻转开关是全局的，粒子贴图在主线程上会打开它；工作线程用自己线程的开关，不受影响
+    stbi_set_flip_vertically_on_load_thread(0);
+
+    image.filename = filename;
+    image.pixels.reset(stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0));
+}
+
+void AssetLoader::DecodeImage(const std::string& filename, const unsigned char* bytes, size_t size, DecodedImage& image)
+{
+    stbi_set_flip_vertically_on_load_thread(0);
+
+    image.filename = filename;
+    image.pixels.reset(stbi_load_from_memory(bytes, (int)size, &image.width, &image.height, &image.components, 0));
+}
+
+GLuint AssetLoader::UploadTexture(const DecodedImage& image)
+{
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+
+    if (!image.pixels)
+    {
+        std::cout << "Texture failed to load at path: " << image.filename << std::endl;
+        return textureID;
+    }
+
+    // 【修复】给 format 一个默认值 GL_RGB，防止未初始化报错
+    GLenum format = GL_RGB;
+    if (image.components == 1)
+        format = GL_RED;
+    else if (image.components == 2)  // 【新增】处理 2 通道 (GL_RG)
+        format = GL_RG;
+    else if (image.components == 3)
+        format = GL_RGB;
+    else if (image.components == 4)
+        format = GL_RGBA;
+
+    // 像素先写进像素缓冲：重新分配 (orphan) 后映射写入，驱动不用等上一次使用这个缓冲的上传完成
+    if (pixelBuffers[0] == 0)
+        glGenBuffers(PBO_COUNT, pixelBuffers);
+    GLuint pixelBuffer = pixelBuffers[nextPixelBuffer];
+    nextPixelBuffer = (nextPixelBuffer + 1) % PBO_COUNT;
+
+    GLsizeiptr size = (GLsizeiptr)image.width * image.height * image.components;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    const void* source = image.pixels.get();
+    if (mapped)
+    {
+        std::memcpy(mapped, image.pixels.get(), (size_t)size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        source = NULL; // 从像素缓冲的开头读取
+    }
+    else
+    {
+        // 映射失败时直接从内存上传
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // stb_image 的行是紧密排列的，1~3 通道的宽度不一定是 4 的倍数
+    GLint previousAlignment = 4;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, source);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // ==========================================================
+    //  针对灰度图 (1通道) 和 灰度透明图 (2通道) 的颜色修正
+    // ==========================================================
+    if (format == GL_RED)
+    {
+        // 如果是单通道(R)，让 G 和 B 也等于 R
+        // 结果：红色 -> 灰色/白色
+        GLint swizzleMask[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+    }
+    else if (format == GL_RG)
+    {
+        // 如果是双通道(R, G)，通常 R 是灰度，G 是透明度(Alpha)
+        // 我们让 G, B 都等于 R，但是让 Alpha 等于 G
+        GLint swizzleMask[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+    }
+    // ==========================================================
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return textureID;
+}
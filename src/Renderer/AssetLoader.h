@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "../Core/ThreadPool.h"
+
+/*
+AssetLoader: 启动时的异步资源加载
+
+窗口一出来就开始渲染，模型在后台陆续加载，加载完的模型下一帧就出现在场景里：
+    - 工作线程 (ThreadPool)：Assimp 导入、stb_image 解码等纯 CPU 的工作，同一个模型的多张纹理并行解码
+    - 主线程 (Update)：所有 GL 调用 (创建纹理、几何体池上传) 排队在主线程执行，每帧最多用 budget 毫秒，
+      超出的留到下一帧 (至少执行一个，保证有进展)。纹理像素先写进像素缓冲 (PBO，几个轮流使用并 orphan)，
+      glTexImage2D 从 PBO 读取，拷贝到显存由驱动异步完成，主线程不用等待
+
+资源计数：每个异步加载的资源发起时 BeginAsset，在主线程上完成 (成功或失败) 时 EndAsset。
+Stop 之后还没开始的任务被丢弃，正在执行的任务通过 IsCancelled 尽快返回；发起加载的对象 (Model) 在 Stop 之前不能销毁。
+*/
+
+// 解码后的图片 (stb_image 的像素，离开作用域时释放)
+struct DecodedImage
+{
+    struct PixelDeleter
+    {
+        void operator()(unsigned char* pixels) const;
+    };
+
+    std::string filename;       // 完整路径 (出错时打印)
+    int width = 0, height = 0, components = 0;
+    std::unique_ptr<unsigned char, PixelDeleter> pixels;
+};
+
+class AssetLoader
+{
+public:
+    static constexpr int PBO_COUNT = 4;
+
+    static AssetLoader& Get();
+
+    // 启动工作线程 (workerThreads <= 0 时按硬件线程数)；没有 Start 时 RunAsync 直接同步执行
+    void Start(int workerThreads = 0);
+    // 丢弃还没开始的任务并等待工作线程结束，释放 PBO (需要 GL 上下文)
+    void Stop();
+    bool IsCancelled() const;
+
+    // 在工作线程上执行 (不能调用 GL)
+    void RunAsync(std::function<void()> job);
+    // 排队到主线程，在下一次 Update 中执行 (任意线程都可以调用，同一线程提交的任务按顺序执行)
+    void RunOnMainThread(std::function<void()> job);
+    // 主线程每帧调用：执行排队的 GL 任务，用时超过 budgetMilliseconds 后停止
+    void Update(double budgetMilliseconds);
+
+    void BeginAsset();
+    void EndAsset();
+    // 还没完成的资源数 / 已经完成的资源数 (完成数变化说明场景里有新东西出现)
+    int GetPendingAssets() const;
+    unsigned int GetCompletedAssets() const;
+
+    // 解码图片 (任意线程)，不做上下翻转；失败时 pixels 为空
+    static void DecodeImage(const std::string& filename, DecodedImage& image);
+    // 从内存里的文件内容解码 (文件已经映射或读入时用，filename 只用于出错时打印)
+    static void DecodeImage(const std::string& filename, const unsigned char* bytes, size_t size, DecodedImage& image);
+    // 创建纹理并上传 (主线程)：像素经 PBO 上传、生成 mipmap，1/2 通道的图片设置灰度 swizzle；
+    // 解码失败的图片仍然返回一个 (空的) 纹理对象
+    GLuint UploadTexture(const DecodedImage& image);
+
+private:
+    ThreadPool pool;
+    std::atomic<bool> cancelled{ false };
+
+    std::mutex queueMutex;
+    std::deque<std::function<void()>> mainThreadJobs;
+
+    std::atomic<int> pendingAssets{ 0 };
+    std::atomic<unsigned int> completedAssets{ 0 };
+
+    GLuint pixelBuffers[PBO_COUNT] = {};
+    int nextPixelBuffer = 0;
+};
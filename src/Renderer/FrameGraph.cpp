@@ -0,0 +1,396 @@
+﻿#include "FrameGraph.h"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+// ==========================================
+// Builder：声明资源读写
+// ==========================================
+
+FrameGraphResource FrameGraph::Builder::Create(const char* name, const RenderTargetDesc& desc)
+{
+    FrameGraph::Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    graph.resources.push_back(resource);
+
+    FrameGraphResource handle;
+    handle.id = (int)graph.resources.size() - 1;
+    return handle;
+}
+
+FrameGraphResource FrameGraph::Builder::Read(FrameGraphResource resource)
+{
+    if (!resource.IsValid()) return resource;
+
+    std::vector<int>& reads = graph.passes[passIndex].reads;
+    if (std::find(reads.begin(), reads.end(), resource.id) == reads.end())
+    {
+        reads.push_back(resource.id);
+        graph.resources[resource.id].readers.push_back(passIndex);
+    }
+    return resource;
+}
+
+FrameGraphResource FrameGraph::Builder::Write(FrameGraphResource resource)
+{
+    if (!resource.IsValid()) return resource;
+
+    std::vector<int>& writes = graph.passes[passIndex].writes;
+    if (std::find(writes.begin(), writes.end(), resource.id) == writes.end())
+    {
+        writes.push_back(resource.id);
+        graph.resources[resource.id].writers.push_back(passIndex);
+    }
+    return resource;
+}
+
+void FrameGraph::Builder::SideEffect()
+{
+    graph.passes[passIndex].sideEffect = true;
+}
+
+// ==========================================
+// 声明
+// ==========================================
+
+void FrameGraph::Reset()
+{
+    resources.clear();
+    passes.clear();
+    order.clear();
+    compiled = false;
+    for (auto& target : pool)
+        target.inUse = false;
+}
+
+FrameGraphResource FrameGraph::ImportRenderTarget(const char* name, GLuint fbo, int width, int height,
+    GLuint colorTexture, GLuint depthTexture)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc.width = width;
+    resource.desc.height = height;
+    resource.imported = true;
+    resource.fbo = fbo;
+    resource.color = colorTexture;
+    resource.depth = depthTexture;
+    resources.push_back(resource);
+
+    FrameGraphResource handle;
+    handle.id = (int)resources.size() - 1;
+    return handle;
+}
+
+void FrameGraph::AddPass(const char* name, const SetupFunc& setup, const ExecuteFunc& execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    passes.push_back(pass);
+
+    Builder builder(*this, (int)passes.size() - 1);
+    setup(builder);
+}
+
+// ==========================================
+// 编译：剔除 + 排序 + 计算资源生命周期
+// ==========================================
+
+void FrameGraph::Compile()
+{
+    // 1. 剔除：从"没人读的临时资源"出发反向传播引用计数
+    //    Pass 的引用计数 = 它写的资源中仍被需要的个数；外部资源永远被需要
+    std::vector<int> passRefs(passes.size(), 0);
+    std::vector<int> resourceRefs(resources.size(), 0);
+    for (size_t r = 0; r < resources.size(); ++r)
+        resourceRefs[r] = (int)resources[r].readers.size();
+
+    for (size_t p = 0; p < passes.size(); ++p)
+    {
+        passes[p].culled = false;
+        passRefs[p] = (int)passes[p].writes.size();
+    }
+
+    std::vector<int> unreferenced;
+    for (size_t r = 0; r < resources.size(); ++r)
+    {
+        if (resources[r].imported) continue;
+        if (resources[r].writers.empty() && !resources[r].readers.empty())
+            std::cout << "WARNING::FRAME_GRAPH:: resource '" << resources[r].name << "' is read but never written" << std::endl;
+        if (resourceRefs[r] == 0)
+            unreferenced.push_back((int)r);
+    }
+
+    // 剔除一个 Pass 后，它读的资源少了一个读者
+    std::function<void(int)> cullPass = [&](int p) {
+        passes[p].culled = true;
+        for (int r : passes[p].reads)
+        {
+            if (--resourceRefs[r] == 0 && !resources[r].imported)
+                unreferenced.push_back(r);
+        }
+    };
+
+    // 什么都不写、也没有声明副作用的 Pass 没有任何输出
+    for (size_t p = 0; p < passes.size(); ++p)
+    {
+        if (passRefs[p] == 0 && !passes[p].sideEffect)
+            cullPass((int)p);
+    }
+
+    while (!unreferenced.empty())
+    {
+        int r = unreferenced.back();
+        unreferenced.pop_back();
+        for (int p : resources[r].writers)
+        {
+            if (passes[p].culled) continue;
+            if (--passRefs[p] == 0 && !passes[p].sideEffect)
+                cullPass(p);
+        }
+    }
+
+    // 2. 排序：写同一资源的 Pass 按声明顺序串起来，读者排在所有写者之后
+    //    拓扑排序时优先取声明顺序靠前的 Pass，没有依赖关系的 Pass 保持声明顺序
+    std::vector<std::vector<int>> edges(passes.size());
+    std::vector<int> inDegree(passes.size(), 0);
+    auto addEdge = [&](int from, int to) {
+        if (from == to || passes[from].culled || passes[to].culled) return;
+        edges[from].push_back(to);
+        ++inDegree[to];
+    };
+
+    for (const auto& resource : resources)
+    {
+        for (size_t i = 1; i < resource.writers.size(); ++i)
+            addEdge(resource.writers[i - 1], resource.writers[i]);
+
+        for (int reader : resource.readers)
+        {
+            // 既读又写 (读-改-写) 的 Pass 已经在写者链里排好了位置
+            if (std::find(resource.writers.begin(), resource.writers.end(), reader) != resource.writers.end())
+                continue;
+            for (int writer : resource.writers)
+                addEdge(writer, reader);
+        }
+    }
+
+    order.clear();
+    std::priority_queue<int, std::vector<int>, std::greater<int>> ready;
+    size_t aliveCount = 0;
+    for (size_t p = 0; p < passes.size(); ++p)
+    {
+        if (passes[p].culled) continue;
+        ++aliveCount;
+        if (inDegree[p] == 0) ready.push((int)p);
+    }
+    while (!ready.empty())
+    {
+        int p = ready.top();
+        ready.pop();
+        order.push_back(p);
+        for (int next : edges[p])
+        {
+            if (--inDegree[next] == 0) ready.push(next);
+        }
+    }
+
+    if (order.size() != aliveCount)
+    {
+        std::cout << "ERROR::FRAME_GRAPH:: dependency cycle detected, falling back to declaration order" << std::endl;
+        order.clear();
+        for (size_t p = 0; p < passes.size(); ++p)
+        {
+            if (!passes[p].culled) order.push_back((int)p);
+        }
+    }
+
+    // 3. 资源生命周期：第一次 / 最后一次被用到时在执行顺序中的位置
+    for (auto& resource : resources)
+    {
+        resource.firstUse = -1;
+        resource.lastUse = -1;
+    }
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        const Pass& pass = passes[order[i]];
+        for (const std::vector<int>* list : { &pass.reads, &pass.writes })
+        {
+            for (int r : *list)
+            {
+                if (resources[r].firstUse < 0) resources[r].firstUse = (int)i;
+                resources[r].lastUse = (int)i;
+            }
+        }
+    }
+
+    compiled = true;
+}
+
+// ==========================================
+// 执行
+// ==========================================
+
+void FrameGraph::Execute()
+{
+    if (!compiled) Compile();
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        Pass& pass = passes[order[i]];
+
+        // 临时资源在第一次用到之前从池里取
+        for (auto& resource : resources)
+        {
+            if (!resource.imported && resource.firstUse == (int)i)
+                resource.target = AcquireTarget(resource.desc);
+        }
+
+        // 只写一个渲染目标的 Pass：替它绑定 FBO 与视口
+        if (pass.writes.size() == 1)
+        {
+            FrameGraphResource target;
+            target.id = pass.writes[0];
+            const RenderTargetDesc& desc = resources[target.id].desc;
+            glBindFramebuffer(GL_FRAMEBUFFER, GetFramebuffer(target));
+            glViewport(0, 0, desc.width, desc.height);
+        }
+
+        pass.execute(*this);
+
+        // 最后一次用完后还回池里，后面描述相同的资源可以复用
+        for (auto& resource : resources)
+        {
+            if (!resource.imported && resource.lastUse == (int)i && resource.target >= 0)
+                pool[resource.target].inUse = false;
+        }
+    }
+}
+
+// ==========================================
+// 渲染目标池
+// ==========================================
+
+int FrameGraph::AcquireTarget(const RenderTargetDesc& desc)
+{
+    for (size_t i = 0; i < pool.size(); ++i)
+    {
+        if (!pool[i].inUse && pool[i].desc == desc)
+        {
+            pool[i].inUse = true;
+            return (int)i;
+        }
+    }
+
+    RenderTarget target;
+    target.desc = desc;
+    CreateTarget(target);
+    target.inUse = true;
+    pool.push_back(target);
+    return (int)pool.size() - 1;
+}
+
+void FrameGraph::CreateTarget(RenderTarget& target)
+{
+    const RenderTargetDesc& desc = target.desc;
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+
+    if (desc.colorFormat != 0)
+    {
+        glGenTextures(1, &target.color);
+        glBindTexture(GL_TEXTURE_2D, target.color);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.colorFormat, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, 0);
+    }
+    else
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    if (desc.depthFormat != 0)
+    {
+        bool stencil = desc.depthFormat == GL_DEPTH24_STENCIL8 || desc.depthFormat == GL_DEPTH32F_STENCIL8;
+        glGenTextures(1, &target.depth);
+        glBindTexture(GL_TEXTURE_2D, target.depth);
+        if (stencil)
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.depthFormat, desc.width, desc.height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, desc.depthFormat, desc.width, desc.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        // 深度纹理多半被当作阴影图采样：范围以外取 1.0 (没有遮挡)，防止阴影以外的区域变黑
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+            GL_TEXTURE_2D, target.depth, 0);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::FRAME_GRAPH:: Framebuffer is not complete!" << std::endl;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// ==========================================
+// 查询
+// ==========================================
+
+GLuint FrameGraph::GetFramebuffer(FrameGraphResource resource) const
+{
+    if (!resource.IsValid()) return 0;
+    const Resource& r = resources[resource.id];
+    if (r.imported) return r.fbo;
+    return r.target >= 0 ? pool[r.target].fbo : 0;
+}
+
+GLuint FrameGraph::GetColorTexture(FrameGraphResource resource) const
+{
+    if (!resource.IsValid()) return 0;
+    const Resource& r = resources[resource.id];
+    if (r.imported) return r.color;
+    return r.target >= 0 ? pool[r.target].color : 0;
+}
+
+GLuint FrameGraph::GetDepthTexture(FrameGraphResource resource) const
+{
+    if (!resource.IsValid()) return 0;
+    const Resource& r = resources[resource.id];
+    if (r.imported) return r.depth;
+    return r.target >= 0 ? pool[r.target].depth : 0;
+}
+
+GLuint FrameGraph::GetTexture(FrameGraphResource resource) const
+{
+    GLuint depth = GetDepthTexture(resource);
+    return depth != 0 ? depth : GetColorTexture(resource);
+}
+
+void FrameGraph::PrintSummary() const
+{
+    std::cout << "FrameGraph: ";
+    for (size_t i = 0; i < order.size(); ++i)
+        std::cout << (i > 0 ? " -> " : "") << passes[order[i]].name;
+
+    bool anyCulled = false;
+    for (const auto& pass : passes)
+    {
+        if (!pass.culled) continue;
+        std::cout << (anyCulled ? ", " : "  (culled: ") << pass.name;
+        anyCulled = true;
+    }
+    if (anyCulled) std::cout << ")";
+    std::cout << " | " << pool.size() << " pooled render target(s)" << std::endl;
+}
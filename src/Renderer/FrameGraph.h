@@ -0,0 +1,144 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+FrameGraph: 帧图 (渲染 Pass 调度器)
+
+每帧由调用方声明本帧要做的 Pass，每个 Pass 在 setup 回调里声明它读写哪些资源 (渲染目标)，
+在 execute 回调里发出 GL 调用。Compile 根据读写关系：
+    1. 排序：读某个资源的 Pass 一定排在所有写它的 Pass 之后；写同一资源的 Pass 之间保持声明顺序
+    2. 剔除：输出没有任何 Pass 读取的 Pass 直接剔除 (不会执行)。写外部资源 (如默认帧缓冲) 或
+       声明了 SideEffect 的 Pass 视为有输出，永远保留
+    3. 管理临时渲染目标：Create 出来的资源在第一个用到它的 Pass 之前从池里取，最后一个用到它的 Pass
+       之后还回池里；池跨帧保留，描述相同的目标每帧复用同一份 GL 对象，帧循环中不再创建纹理
+Execute 按排好的顺序执行，Pass 只写一个渲染目标时会先绑定它的 FBO 并把视口设成它的尺寸。
+
+使用方法 (每帧)：
+    frameGraph.Reset();
+    FrameGraphResource backbuffer = frameGraph.ImportRenderTarget("Backbuffer", 0, width, height);
+    FrameGraphResource shadowMap;
+    frameGraph.AddPass("Shadow",
+        [&](FrameGraph::Builder& builder) { shadowMap = builder.Write(builder.Create("ShadowMap", desc)); },
+        [&](const FrameGraph& graph) { ... 画深度 ... });
+    frameGraph.AddPass("Scene",
+        [&](FrameGraph::Builder& builder) { builder.Read(shadowMap); builder.Write(backbuffer); },
+        [&](const FrameGraph& graph) { glBindTexture(GL_TEXTURE_2D, graph.GetTexture(shadowMap)); ... });
+    frameGraph.Compile();
+    frameGraph.Execute();
+*/
+
+// 资源句柄 (只在声明它的那一帧内有效)
+struct FrameGraphResource
+{
+    int id = -1;
+    bool IsValid() const { return id >= 0; }
+};
+
+// 临时渲染目标的描述：format 为 0 表示没有该附件
+struct RenderTargetDesc
+{
+    int width = 0;
+    int height = 0;
+    GLenum colorFormat = 0;     // 例如 GL_RGBA8
+    GLenum depthFormat = 0;     // 例如 GL_DEPTH_COMPONENT24
+
+    bool operator==(const RenderTargetDesc& other) const
+    {
+        return width == other.width && height == other.height &&
+            colorFormat == other.colorFormat && depthFormat == other.depthFormat;
+    }
+};
+
+class FrameGraph
+{
+public:
+    // setup 回调中用来声明资源读写
+    class Builder
+    {
+    public:
+        // 创建一个临时渲染目标 (由帧图分配与回收)
+        FrameGraphResource Create(const char* name, const RenderTargetDesc& desc);
+        FrameGraphResource Read(FrameGraphResource resource);
+        FrameGraphResource Write(FrameGraphResource resource);
+        // 输出不在帧图里 (例如写 CPU 端数据)，永远不剔除
+        void SideEffect();
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, int passIndex) : graph(graph), passIndex(passIndex) {}
+        FrameGraph& graph;
+        int passIndex;
+    };
+
+    using SetupFunc = std::function<void(Builder&)>;
+    using ExecuteFunc = std::function<void(const FrameGraph&)>;
+
+    // 清空上一帧声明的 Pass 与资源 (渲染目标池保留)
+    void Reset();
+
+    // 外部资源：生命周期不归帧图管 (默认帧缓冲传 fbo = 0)，写它的 Pass 永远不剔除
+    FrameGraphResource ImportRenderTarget(const char* name, GLuint fbo, int width, int height,
+        GLuint colorTexture = 0, GLuint depthTexture = 0);
+
+    void AddPass(const char* name, const SetupFunc& setup, const ExecuteFunc& execute);
+
+    // 排序 + 剔除，出现环时打印错误并退回声明顺序
+    void Compile();
+    void Execute();
+
+    // 供 execute 回调查询资源对应的 GL 对象
+    GLuint GetFramebuffer(FrameGraphResource resource) const;
+    GLuint GetColorTexture(FrameGraphResource resource) const;
+    GLuint GetDepthTexture(FrameGraphResource resource) const;
+    // 有深度附件时返回深度纹理 (阴影图)，否则返回颜色纹理
+    GLuint GetTexture(FrameGraphResource resource) const;
+
+    // 打印上一次 Compile 的执行顺序与被剔除的 Pass，便于调试
+    void PrintSummary() const;
+
+private:
+    struct RenderTarget
+    {
+        RenderTargetDesc desc;
+        GLuint fbo = 0;
+        GLuint color = 0;
+        GLuint depth = 0;
+        bool inUse = false;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported = false;
+        int target = -1;            // 临时资源：池中的下标 (执行期间有效)
+        GLuint fbo = 0, color = 0, depth = 0;   // 外部资源
+        std::vector<int> writers;   // 按声明顺序
+        std::vector<int> readers;
+        int firstUse = -1, lastUse = -1;    // 在执行顺序中的位置
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteFunc execute;
+        std::vector<int> reads;
+        std::vector<int> writes;
+        bool sideEffect = false;
+        bool culled = false;
+    };
+
+    int AcquireTarget(const RenderTargetDesc& desc);
+    void CreateTarget(RenderTarget& target);
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<int> order;             // Compile 后的执行顺序 (只含未剔除的 Pass)
+    std::vector<RenderTarget> pool;     // 跨帧保留，GL 对象随上下文一起释放
+    bool compiled = false;
+};
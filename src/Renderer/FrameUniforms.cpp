@@ -0,0 +1,68 @@
+﻿#include "FrameUniforms.h"
+
+#include <algorithm>
+#include <cstring>
+
+// 结构体布局必须与着色器里的 std140 块一致
+static_assert(sizeof(FrameUniforms::CameraBlock) == 144, "Camera block layout");
+static_assert(sizeof(FrameUniforms::SunBlock) == 32, "Sun block layout");
+static_assert(sizeof(FrameUniforms::PointLight) == 48, "PointLight layout");
+static_assert(sizeof(FrameUniforms::LampBlock) == 208, "Lamps block layout");
+static_assert(sizeof(FrameUniforms::ShadowBlock) == 416, "Shadow block layout");
+
+static const char* BLOCK_NAMES[4] = { "Camera", "Sun", "Lamps", "Shadow" };
+
+void FrameUniforms::Init()
+{
+    if (buffer != 0) return;
+
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    size_t align = (size_t)std::max(alignment, 1);
+
+    const size_t sizes[4] = { sizeof(CameraBlock), sizeof(SunBlock), sizeof(LampBlock), sizeof(ShadowBlock) };
+    totalSize = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        offsets[i] = totalSize;
+        totalSize = (totalSize + sizes[i] + align - 1) / align * align;
+    }
+    staging.assign(totalSize, 0);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)totalSize, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // 绑定点与缓冲区间的对应关系只设置一次 (orphan 不改变缓冲的名字)
+    const GLuint bindings[4] = { CAMERA_BINDING, SUN_BINDING, LAMP_BINDING, SHADOW_BINDING };
+    for (int i = 0; i < 4; ++i)
+        glBindBufferRange(GL_UNIFORM_BUFFER, bindings[i], buffer, (GLintptr)offsets[i], (GLsizeiptr)sizes[i]);
+}
+
+void FrameUniforms::BindBlocks(GLuint program)
+{
+    const GLuint bindings[4] = { CAMERA_BINDING, SUN_BINDING, LAMP_BINDING, SHADOW_BINDING };
+    for (int i = 0; i < 4; ++i)
+    {
+        GLuint index = glGetUniformBlockIndex(program, BLOCK_NAMES[i]);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, bindings[i]);
+    }
+}
+
+void FrameUniforms::Upload()
+{
+    if (buffer == 0) return;
+
+    std::memcpy(&staging[offsets[0]], &camera, sizeof(CameraBlock));
+    std::memcpy(&staging[offsets[1]], &sun, sizeof(SunBlock));
+    std::memcpy(&staging[offsets[2]], &lamps, sizeof(LampBlock));
+    std::memcpy(&staging[offsets[3]], &shadow, sizeof(ShadowBlock));
+
+    // 先 orphan：上一帧还在读旧内容的绘制不会让这次写入等待
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)totalSize, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)totalSize, staging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/*
+FrameUniforms: 每帧共享的 uniform 块 (std140)
+
+相机、太阳、路灯与阴影的数据每帧只写一次，所有用到它们的程序 (basic / shadow_depth / particle / sun / skybox)
+通过同一个 UBO 读取，不再逐个程序、逐个名字设置 uniform：
+    Camera (绑定点 0): 投影、视图矩阵与相机位置
+    Sun    (绑定点 1): 太阳位置、颜色、强度与环境光
+    Lamps  (绑定点 2): 路灯 (点光源) 与总开关
+    Shadow (绑定点 3): 各级联的光空间矩阵、覆盖深度与偏移参数；最后一个矩阵是降雪遮挡高度图的投影
+
+四个块放在同一个缓冲里 (按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐)，Upload 时整体重新分配 (orphan) 后
+一次 glBufferSubData 写入，各绑定点用 glBindBufferRange 指向自己的那一段。
+下面的结构体与着色器里的块逐字节对应 (std140：vec3 后面跟一个 float 正好凑满 16 字节，数组元素按 16 字节对齐)。
+*/
+class FrameUniforms
+{
+public:
+    static constexpr GLuint CAMERA_BINDING = 0;
+    static constexpr GLuint SUN_BINDING = 1;
+    static constexpr GLuint LAMP_BINDING = 2;
+    static constexpr GLuint SHADOW_BINDING = 3;
+
+    static constexpr int MAX_LAMPS = 4;         // basic.frag 的 NR_POINT_LIGHTS
+    static constexpr int MAX_CASCADES = 4;      // basic.frag / shadow_depth.vert 的 MAX_CASCADES
+    // Shadow 块里降雪遮挡高度图的矩阵下标 (shadow_depth.vert 的 lightSpaceIndex)
+    static constexpr int OCCLUSION_LIGHT_SPACE = MAX_CASCADES;
+
+    struct CameraBlock
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::vec3 viewPos;
+        float padding0;
+    };
+
+    struct SunBlock
+    {
+        glm::vec3 lightPos;         // 太阳的世界位置 (basic.frag 用它算光线方向)
+        float sunIntensity;
+        glm::vec3 lightColor;
+        float ambientStrength;
+    };
+
+    struct PointLight
+    {
+        glm::vec3 position;
+        float constant;
+        glm::vec3 color;
+        float linear;
+        float quadratic;
+        float padding0[3];
+    };
+
+    struct LampBlock
+    {
+        PointLight pointLights[MAX_LAMPS];
+        int lampOn;                 // GLSL 的 bool 在 std140 里占 4 字节
+        int padding0[3];
+    };
+
+    struct ShadowBlock
+    {
+        glm::mat4 lightSpaceMatrices[MAX_CASCADES + 1];
+        glm::vec4 cascadeSplits;                    // 每一级覆盖到的视空间深度
+        glm::vec4 cascadeParams[MAX_CASCADES];      // x: 一个纹素的世界尺寸, y: 光空间深度范围
+        int cascadeCount;
+        int padding0[3];
+    };
+
+    // 创建缓冲并绑定到各绑定点 (需要 GL 上下文)
+    void Init();
+    // 把程序里的同名块 (Camera / Sun / Lamps / Shadow) 连到对应的绑定点，程序里没有的块跳过
+    static void BindBlocks(GLuint program);
+
+    // 写入本帧的数据 (每帧一次，在所有 Pass 之前)
+    void Upload();
+
+    CameraBlock camera = {};
+    SunBlock sun = {};
+    LampBlock lamps = {};
+    ShadowBlock shadow = {};
+
+private:
+    GLuint buffer = 0;
+    size_t offsets[4] = {};
+    size_t totalSize = 0;
+    std::vector<unsigned char> staging;
+};
@@ -0,0 +1,149 @@
+﻿#include "GLStateCache.h"
+
+#include <glm/glm.hpp>
+
+void GLStateCache::BeginFrame()
+{
+    lastFrameStats = stats;
+    stats = Stats();
+    Invalidate();
+}
+
+void GLStateCache::Invalidate()
+{
+    program = -1;
+    vertexArray = -1;
+    activeUnit = -1;
+    for (int i = 0; i < MAX_UNITS; ++i)
+    {
+        textures[i] = -1;
+        textureTargets[i] = 0;
+    }
+    cullFace = blend = depthTest = -1;
+    // 缓冲可能在缓存之外被删除并重用了名字，实例属性也重新设置
+    instanceBuffers.clear();
+}
+
+void GLStateCache::UseProgram(GLuint value)
+{
+    if (program == (long long)value)
+    {
+        ++stats.program.elided;
+        return;
+    }
+    glUseProgram(value);
+    program = value;
+    ++stats.program.issued;
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    if (vertexArray == (long long)vao)
+    {
+        ++stats.vertexArray.elided;
+        return;
+    }
+    glBindVertexArray(vao);
+    vertexArray = vao;
+    ++stats.vertexArray.issued;
+}
+
+void GLStateCache::ActiveTexture(int unit)
+{
+    if (activeUnit == unit) return;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    activeUnit = unit;
+}
+
+void GLStateCache::BindTexture(int unit, GLenum target, GLuint texture)
+{
+    if (unit < MAX_UNITS && textures[unit] == (long long)texture && textureTargets[unit] == target)
+    {
+        ++stats.texture.elided;
+        return;
+    }
+    ActiveTexture(unit);
+    glBindTexture(target, texture);
+    if (unit < MAX_UNITS)
+    {
+        textures[unit] = texture;
+        textureTargets[unit] = target;
+    }
+    ++stats.texture.issued;
+}
+
+void GLStateCache::SetCapability(GLenum capability, int& cached, bool enabled)
+{
+    if (cached == (enabled ? 1 : 0))
+    {
+        ++stats.capability.elided;
+        return;
+    }
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+    cached = enabled ? 1 : 0;
+    ++stats.capability.issued;
+}
+
+void GLStateCache::SetCullFace(bool enabled)
+{
+    SetCapability(GL_CULL_FACE, cullFace, enabled);
+}
+
+void GLStateCache::SetBlend(bool enabled)
+{
+    SetCapability(GL_BLEND, blend, enabled);
+}
+
+void GLStateCache::SetDepthTest(bool enabled)
+{
+    SetCapability(GL_DEPTH_TEST, depthTest, enabled);
+}
+
+void GLStateCache::SetInstanceBuffer(GLuint buffer)
+{
+    // VAO 必须是经过缓存绑定的，否则不知道在改哪个 VAO
+    GLuint vao = (GLuint)vertexArray;
+    auto it = instanceBuffers.find(vao);
+    if (it != instanceBuffers.end() && it->second == buffer)
+    {
+        ++stats.instanceBuffer.elided;
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    // 实例的模型矩阵：一个 mat4 占 4 个属性位置 (每个位置一列)，每个实例前进一次
+    for (int column = 0; column < 4; ++column)
+    {
+        if (it == instanceBuffers.end())
+        {
+            glEnableVertexAttribArray(3 + column);
+            glVertexAttribDivisor(3 + column, 1);
+        }
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * column));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instanceBuffers[vao] = buffer;
+    ++stats.instanceBuffer.issued;
+}
+
+void GLStateCache::ForgetBuffer(GLuint buffer)
+{
+    for (auto it = instanceBuffers.begin(); it != instanceBuffers.end();)
+    {
+        if (it->second == buffer)
+            it = instanceBuffers.erase(it);
+        else
+            ++it;
+    }
+}
+
+GLStateCache::Stats& GLStateCache::GetStats()
+{
+    return stats;
+}
+
+const GLStateCache::Stats& GLStateCache::GetLastFrameStats() const
+{
+    return lastFrameStats;
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <unordered_map>
+
+/*
+GLStateCache: OpenGL 状态缓存
+
+记住当前绑定的着色器程序、VAO、每个纹理单元上的纹理、当前活动的纹理单元，以及面剔除/混合/深度测试
+的开关，设置的值与缓存相同时直接跳过对应的 GL 调用，并分别统计实际发出与被省掉的次数。
+VAO 的实例属性 (3~6) 指向哪个实例缓冲也记录在这里 (按 VAO 记，VAO 本身保存这个状态)。
+
+缓存只知道经过它的调用：别的代码直接调用 glUseProgram/glBindTexture/glEnable 之后缓存就不准了。
+所以每帧开始调用 BeginFrame (全部视为未知，第一次设置一定会发出)，并且在同一帧里，
+通过 RenderQueue 绘制的 Pass 之间不要绕过缓存修改这些状态 (需要时用缓存的接口设置)。
+*/
+class GLStateCache
+{
+public:
+    // 一类状态的统计
+    struct Counter
+    {
+        unsigned int issued = 0;    // 实际发出的 GL 调用
+        unsigned int elided = 0;    // 与缓存相同而省掉的调用
+    };
+    struct Stats
+    {
+        Counter program;
+        Counter vertexArray;
+        Counter texture;            // glBindTexture (含随之需要的 glActiveTexture)
+        Counter capability;         // glEnable / glDisable
+        Counter instanceBuffer;     // 实例属性指针 (4 次 glVertexAttribPointer 算一次)
+    };
+
+    // 每帧开始：缓存全部失效，上一帧的统计存到 GetLastFrameStats
+    void BeginFrame();
+    // 只让缓存失效 (别的代码直接改过状态之后)
+    void Invalidate();
+
+    void UseProgram(GLuint program);
+    void BindVertexArray(GLuint vao);
+    // 把 texture 绑定到 unit 号纹理单元
+    void BindTexture(int unit, GLenum target, GLuint texture);
+    // 切换活动纹理单元 (绑定纹理以外的代码假设活动单元是 0 时用它恢复)
+    void ActiveTexture(int unit);
+    void SetCullFace(bool enabled);
+    void SetBlend(bool enabled);
+    void SetDepthTest(bool enabled);
+    // 把当前绑定的 VAO 的属性 3~6 指向 buffer (每个实例一个 mat4)
+    void SetInstanceBuffer(GLuint buffer);
+    // 缓冲被删除之前调用：忘掉指向它的 VAO (缓冲名可能被重用，不能再当作已经指向)
+    void ForgetBuffer(GLuint buffer);
+
+    // 当前帧到目前为止的统计
+    Stats& GetStats();
+    // 上一个完整帧的统计
+    const Stats& GetLastFrameStats() const;
+
+private:
+    static const int MAX_UNITS = 16;
+
+    void SetCapability(GLenum capability, int& cached, bool enabled);
+
+    // -1 表示未知
+    long long program = -1;
+    long long vertexArray = -1;
+    int activeUnit = -1;
+    long long textures[MAX_UNITS];
+    GLenum textureTargets[MAX_UNITS];
+    int cullFace = -1, blend = -1, depthTest = -1;
+    // VAO -> 实例属性指向的缓冲 (只由缓存修改，Invalidate 时也清除)
+    std::unordered_map<GLuint, GLuint> instanceBuffers;
+
+    Stats stats;
+    Stats lastFrameStats;
+};
@@ -0,0 +1,142 @@
+﻿#include "GeometryPool.h"
+#include "Mesh.h"
+
+#include <algorithm>
+#include <cstddef>
+
+GeometryPool& GeometryPool::Get()
+{
+    static GeometryPool pool;
+    return pool;
+}
+
+int GeometryPool::CreatePage(GLsizei vertexCapacity, GLsizei indexCapacity)
+{
+    Page page;
+    page.vertexCapacity = vertexCapacity;
+    page.indexCapacity = indexCapacity;
+
+    glGenVertexArrays(1, &page.vao);
+    glGenBuffers(1, &page.vbo);
+    glGenBuffers(1, &page.ebo);
+
+    glBindVertexArray(page.vao);
+
+    // 只分配空间，网格加载时再用 glBufferSubData 填进去
+    glBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * sizeof(Vertex), NULL, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+
+    // 顶点属性与 Mesh 原来的布局一致
+    // 1. 位置
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // 2. 法线
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    // 3. 纹理坐标
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    pages.push_back(page);
+    return (int)pages.size() - 1;
+}
+
+GeometryRange GeometryPool::Add(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    return Add(vertices.data(), (GLsizei)vertices.size(), indices.data(), (GLsizei)indices.size());
+}
+
+GeometryRange GeometryPool::Add(const Vertex* vertices, GLsizei vertexCount, const unsigned int* indices, GLsizei indexCount)
+{
+    auto fits = [&](const Page& page) {
+        return page.vertexCount + vertexCount <= page.vertexCapacity && page.indexCount + indexCount <= page.indexCapacity;
+    };
+
+    // 新网格追加到最后一页 (同一模型的网格尽量在同一页)；放不下时先找已经整页释放的页，再开新的一页
+    int pageIndex = (int)pages.size() - 1;
+    if (pageIndex < 0 || !fits(pages[pageIndex]))
+    {
+        pageIndex = -1;
+        for (int i = 0; i < (int)pages.size(); ++i)
+        {
+            if (pages[i].liveRanges == 0 && fits(pages[i]))
+            {
+                pageIndex = i;
+                break;
+            }
+        }
+        if (pageIndex < 0)
+            pageIndex = CreatePage(std::max(PAGE_VERTICES, vertexCount), std::max(PAGE_INDICES, indexCount));
+    }
+    Page& page = pages[pageIndex];
+
+    GeometryRange range;
+    range.page = pageIndex;
+    range.baseVertex = page.vertexCount;
+    range.firstIndex = (GLuint)page.indexCount;
+    range.indexCount = indexCount;
+
+    if (vertexCount > 0)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)page.vertexCount * sizeof(Vertex),
+            (GLsizeiptr)vertexCount * sizeof(Vertex), vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if (indexCount > 0)
+    {
+        // EBO 属于 VAO 的状态，绑定 VAO 后再更新，避免改动当前绑定的其它 VAO
+        glBindVertexArray(page.vao);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)page.indexCount * sizeof(unsigned int),
+            (GLsizeiptr)indexCount * sizeof(unsigned int), indices);
+        glBindVertexArray(0);
+    }
+
+    page.vertexCount += vertexCount;
+    page.indexCount += indexCount;
+    ++page.liveRanges;
+    return range;
+}
+
+void GeometryPool::Free(const GeometryRange& range)
+{
+    if (range.page < 0 || range.page >= (int)pages.size()) return;
+    // 页内不整理碎片：最后一个网格释放后整页清空，之后的网格可以重新使用 (不需要 GL 调用)
+    Page& page = pages[range.page];
+    if (--page.liveRanges == 0)
+    {
+        page.vertexCount = 0;
+        page.indexCount = 0;
+    }
+}
+
+GLuint GeometryPool::GetVertexArray(int page) const
+{
+    return pages[page].vao;
+}
+
+int GeometryPool::GetPageCount() const
+{
+    return (int)pages.size();
+}
+
+size_t GeometryPool::GetVertexCount() const
+{
+    size_t count = 0;
+    for (const auto& page : pages)
+        count += page.vertexCount;
+    return count;
+}
+
+size_t GeometryPool::GetIndexCount() const
+{
+    size_t count = 0;
+    for (const auto& page : pages)
+        count += page.indexCount;
+    return count;
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+#include <vector>
+
+struct Vertex;
+
+/*
+GeometryPool: 静态几何体池
+
+所有模型的顶点与索引在加载时依次追加进少数几个大缓冲 ("页")，每页一个 VAO + VBO + EBO，
+网格只记录自己在哪一页、顶点/索引的起始位置与索引数 (GeometryRange)。
+绘制时同一页的所有网格共用一个 VAO，不用再为每个网格切换 VAO；同一材质的多个网格可以用
+glMultiDrawElementsBaseVertex 一次提交 (见 Model::Submit 与 RenderQueue)。
+
+    - 每页预留 PAGE_VERTICES 个顶点、PAGE_INDICES 个索引，放不下时开新的一页；
+      比一页还大的网格单独占一页 (按实际大小分配)
+    - 网格销毁时 Free 它的范围；一页里的网格全部释放后这一页清空重用 (页内的空洞不回收)
+    - 属性 0~2 是 Vertex 的位置/法线/纹理坐标；属性 3~6 是实例的模型矩阵，由 GLStateCache::SetInstanceBuffer
+      指向调用方的实例缓冲 (每个模型各有一个，绘制该模型之前重新指向)
+    - 缓冲随 GL 上下文一起释放 (全局对象析构时上下文可能已经销毁)
+*/
+
+// 网格在几何体池中的位置
+struct GeometryRange
+{
+    int page = -1;
+    GLint baseVertex = 0;       // 顶点起始位置 (索引相对它计数)
+    GLuint firstIndex = 0;      // 索引起始位置
+    GLsizei indexCount = 0;
+};
+
+class GeometryPool
+{
+public:
+    static constexpr GLsizei PAGE_VERTICES = 256 * 1024;    // 8 MB
+    static constexpr GLsizei PAGE_INDICES = 1024 * 1024;    // 4 MB
+
+    // 全局唯一的池 (需要 GL 上下文)
+    static GeometryPool& Get();
+
+    // 上传一个网格，返回它在池中的位置
+    GeometryRange Add(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    // 同上，直接从指针上传 (比如映射的网格缓存文件)
+    GeometryRange Add(const Vertex* vertices, GLsizei vertexCount, const unsigned int* indices, GLsizei indexCount);
+    // 归还一个网格的范围 (只是记账，不调用 GL，上下文销毁后也可以调用)
+    void Free(const GeometryRange& range);
+
+    // 第 page 页的 VAO (通过 GLStateCache::BindVertexArray 绑定)
+    GLuint GetVertexArray(int page) const;
+
+    int GetPageCount() const;
+    // 已使用的顶点数 / 索引数 (所有页)
+    size_t GetVertexCount() const;
+    size_t GetIndexCount() const;
+
+private:
+    GeometryPool() = default;
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    struct Page
+    {
+        GLuint vao = 0, vbo = 0, ebo = 0;
+        GLsizei vertexCapacity = 0, indexCapacity = 0;
+        GLsizei vertexCount = 0, indexCount = 0;
+        int liveRanges = 0;     // 页里还没释放的网格数
+    };
+
+    int CreatePage(GLsizei vertexCapacity, GLsizei indexCapacity);
+
+    std::vector<Page> pages;
+};
@@ -0,0 +1,465 @@
+﻿#include "GltfLoader.h"
+#include "Mesh.h"
+#include "../Core/Json.h"
+#include "../Core/MappedFile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+// glTF 的常量
+static const int COMPONENT_UNSIGNED_BYTE = 5121;
+static const int COMPONENT_UNSIGNED_SHORT = 5123;
+static const int COMPONENT_UNSIGNED_INT = 5125;
+static const int COMPONENT_FLOAT = 5126;
+static const int MODE_TRIANGLES = 4;
+// 节点层级的最大深度 (损坏的文件里可能有环)
+static const int MAX_NODE_DEPTH = 64;
+
+namespace
+{
+    // 访问器在映射内存中的位置
+    struct AccessorView
+    {
+        const unsigned char* data = nullptr;
+        size_t stride = 0;
+        size_t count = 0;
+        int componentType = 0;
+    };
+
+    // 一个节点引用的一个图元 (世界变换已经算好)
+    struct PrimitiveInstance
+    {
+        const JsonValue* primitive;
+        glm::mat4 world;
+    };
+
+    struct GltfFile
+    {
+        JsonValue document;
+        std::string directory;
+        std::vector<std::unique_ptr<MappedFile>> buffers;
+
+        const JsonValue& Array(const char* name) const
+        {
+            static const JsonValue empty;
+            const JsonValue* value = document.Find(name);
+            return value && value->IsArray() ? *value : empty;
+        }
+    };
+}
+
+// URI 里的 %XX 转义 (文件名里的空格等)
+static std::string DecodeUri(const std::string& uri)
+{
+    std::string result;
+    for (size_t i = 0; i < uri.size(); ++i)
+    {
+        if (uri[i] == '%' && i + 2 < uri.size())
+        {
+            char hex[3] = { uri[i + 1], uri[i + 2], '\0' };
+            char* end = nullptr;
+            long value = std::strtol(hex, &end, 16);
+            if (end == hex + 2)
+            {
+                result += (char)value;
+                i += 2;
+                continue;
+            }
+        }
+        result += uri[i];
+    }
+    return result;
+}
+
+static size_t ComponentCount(const std::string& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+static size_t ComponentSize(int componentType)
+{
+    switch (componentType)
+    {
+    case COMPONENT_UNSIGNED_BYTE: return 1;
+    case COMPONENT_UNSIGNED_SHORT: return 2;
+    case COMPONENT_UNSIGNED_INT:
+    case COMPONENT_FLOAT: return 4;
+    default: return 0;
+    }
+}
+
+// 找到访问器的数据并检查范围；expectedType 为空时不检查类型
+static bool GetAccessor(const GltfFile& file, int index, const char* expectedType, AccessorView& view)
+{
+    const JsonValue& accessors = file.Array("accessors");
+    if (index < 0 || (size_t)index >= accessors.Size()) return false;
+    const JsonValue& accessor = accessors[index];
+    if (accessor.Find("sparse")) return false;
+
+    std::string type = accessor.GetString("type");
+    if (expectedType && type != expectedType) return false;
+    view.componentType = accessor.GetInt("componentType");
+    size_t elementSize = ComponentCount(type) * ComponentSize(view.componentType);
+    if (elementSize == 0) return false;
+    view.count = (size_t)accessor.GetNumber("count", 0.0);
+
+    const JsonValue& bufferViews = file.Array("bufferViews");
+    int viewIndex = accessor.GetInt("bufferView", -1);
+    if (viewIndex < 0 || (size_t)viewIndex >= bufferViews.Size()) return false;
+    const JsonValue& bufferView = bufferViews[viewIndex];
+
+    int bufferIndex = bufferView.GetInt("buffer", -1);
+    if (bufferIndex < 0 || (size_t)bufferIndex >= file.buffers.size()) return false;
+    const MappedFile& buffer = *file.buffers[bufferIndex];
+
+    size_t viewOffset = (size_t)bufferView.GetNumber("byteOffset", 0.0);
+    size_t viewLength = (size_t)bufferView.GetNumber("byteLength", 0.0);
+    size_t accessorOffset = (size_t)accessor.GetNumber("byteOffset", 0.0);
+    view.stride = (size_t)bufferView.GetNumber("byteStride", 0.0);
+    if (view.stride == 0) view.stride = elementSize;
+
+    // 最后一个元素也要落在缓冲视图与缓冲文件里
+    if (viewOffset + viewLength > buffer.GetSize()) return false;
+    if (view.count > 0 && accessorOffset + (view.count - 1) * view.stride + elementSize > viewLength) return false;
+
+    view.data = buffer.GetData() + viewOffset + accessorOffset;
+    return true;
+}
+
+static glm::mat4 LocalTransform(const JsonValue& node)
+{
+    const JsonValue* matrix = node.Find("matrix");
+    if (matrix && matrix->Size() == 16)
+    {
+        float values[16];
+        for (int i = 0; i < 16; ++i)
+            values[i] = (float)(*matrix)[i].AsNumber();
+        return glm::make_mat4(values); // glTF 与 glm 都是列主序
+    }
+
+    glm::mat4 transform(1.0f);
+    const JsonValue* translation = node.Find("translation");
+    if (translation && translation->Size() == 3)
+        transform = glm::translate(transform, glm::vec3((float)(*translation)[0].AsNumber(),
+            (float)(*translation)[1].AsNumber(), (float)(*translation)[2].AsNumber()));
+    const JsonValue* rotation = node.Find("rotation");
+    if (rotation && rotation->Size() == 4)
+    {
+        // glTF 的四元数是 [x, y, z, w]
+        glm::quat q((float)(*rotation)[3].AsNumber(), (float)(*rotation)[0].AsNumber(),
+            (float)(*rotation)[1].AsNumber(), (float)(*rotation)[2].AsNumber());
+        transform *= glm::mat4_cast(q);
+    }
+    const JsonValue* scale = node.Find("scale");
+    if (scale && scale->Size() == 3)
+        transform = glm::scale(transform, glm::vec3((float)(*scale)[0].AsNumber(),
+            (float)(*scale)[1].AsNumber(), (float)(*scale)[2].AsNumber()));
+    return transform;
+}
+
+// 遍历节点层级，收集每个图元及其世界变换
+static bool CollectPrimitives(const GltfFile& file, int nodeIndex, const glm::mat4& parent, int depth,
+    std::vector<PrimitiveInstance>& instances)
+{
+    const JsonValue& nodes = file.Array("nodes");
+    if (depth > MAX_NODE_DEPTH || nodeIndex < 0 || (size_t)nodeIndex >= nodes.Size()) return false;
+    const JsonValue& node = nodes[nodeIndex];
+    glm::mat4 world = parent * LocalTransform(node);
+
+    int meshIndex = node.GetInt("mesh", -1);
+    if (meshIndex >= 0)
+    {
+        const JsonValue& meshes = file.Array("meshes");
+        if ((size_t)meshIndex >= meshes.Size()) return false;
+        const JsonValue* primitives = meshes[meshIndex].Find("primitives");
+        if (!primitives) return false;
+        for (size_t i = 0; i < primitives->Size(); ++i)
+            instances.push_back(PrimitiveInstance{ &(*primitives)[i], world });
+    }
+
+    const JsonValue* children = node.Find("children");
+    if (children)
+    {
+        for (size_t i = 0; i < children->Size(); ++i)
+        {
+            if (!CollectPrimitives(file, (*children)[i].AsInt(-1), world, depth + 1, instances))
+                return false;
+        }
+    }
+    return true;
+}
+
+// 把一个图元变换后追加到网格的顶点/索引数组
+static bool AppendPrimitive(const GltfFile& file, const PrimitiveInstance& instance,
+    std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, AABB& bounds)
+{
+    const JsonValue& primitive = *instance.primitive;
+    if (primitive.GetInt("mode", MODE_TRIANGLES) != MODE_TRIANGLES) return false;
+    if (primitive.Find("extensions")) return false; // 比如 KHR_draco_mesh_compression
+    const JsonValue* attributes = primitive.Find("attributes");
+    if (!attributes) return false;
+
+    AccessorView positions, normals, texCoords;
+    const JsonValue* position = attributes->Find("POSITION");
+    const JsonValue* normal = attributes->Find("NORMAL");
+    const JsonValue* texCoord = attributes->Find("TEXCOORD_0");
+    if (!position || !GetAccessor(file, position->AsInt(-1), "VEC3", positions) || positions.componentType != COMPONENT_FLOAT)
+        return false;
+    // 缺少法线时 Assimp 会用 GenNormals 生成，这里不做
+    if (!normal || !GetAccessor(file, normal->AsInt(-1), "VEC3", normals) || normals.componentType != COMPONENT_FLOAT ||
+        normals.count != positions.count)
+        return false;
+    bool hasTexCoords = texCoord != nullptr;
+    if (hasTexCoords && (!GetAccessor(file, texCoord->AsInt(-1), "VEC2", texCoords) ||
+        texCoords.componentType != COMPONENT_FLOAT || texCoords.count != positions.count))
+        return false;
+
+    // 索引 (没有索引时按顺序绘制)
+    size_t baseVertex = vertices.size();
+    const JsonValue* indexAccessor = primitive.Find("indices");
+    if (indexAccessor)
+    {
+        AccessorView view;
+        if (!GetAccessor(file, indexAccessor->AsInt(-1), "SCALAR", view) || view.componentType == COMPONENT_FLOAT)
+            return false;
+        indices.reserve(indices.size() + view.count);
+        for (size_t i = 0; i < view.count; ++i)
+        {
+            const unsigned char* element = view.data + i * view.stride;
+            unsigned int index;
+            if (view.componentType == COMPONENT_UNSIGNED_BYTE)
+            {
+                index = *element;
+            }
+            else if (view.componentType == COMPONENT_UNSIGNED_SHORT)
+            {
+                unsigned short value;
+                std::memcpy(&value, element, sizeof(value));
+                index = value;
+            }
+            else
+            {
+                std::memcpy(&index, element, sizeof(index));
+            }
+            if (index >= positions.count) return false;
+            indices.push_back((unsigned int)baseVertex + index);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < positions.count; ++i)
+            indices.push_back((unsigned int)(baseVertex + i));
+    }
+
+    // 顶点：从映射的缓冲按步长读取，乘上节点变换后直接写成交错格式
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.world)));
+    vertices.resize(baseVertex + positions.count);
+    for (size_t i = 0; i < positions.count; ++i)
+    {
+        Vertex& vertex = vertices[baseVertex + i];
+        glm::vec3 p, n;
+        std::memcpy(&p, positions.data + i * positions.stride, sizeof(p));
+        std::memcpy(&n, normals.data + i * normals.stride, sizeof(n));
+        vertex.Position = glm::vec3(instance.world * glm::vec4(p, 1.0f));
+        n = normalMatrix * n;
+        float length = glm::length(n);
+        vertex.Normal = length > 0.0f ? n / length : n;
+        if (hasTexCoords)
+            std::memcpy(&vertex.TexCoords, texCoords.data + i * texCoords.stride, sizeof(vertex.TexCoords));
+        else
+            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+
+        if (baseVertex + i == 0)
+            bounds = AABB(vertex.Position, vertex.Position);
+        bounds.min = glm::min(bounds.min, vertex.Position);
+        bounds.max = glm::max(bounds.max, vertex.Position);
+    }
+    return true;
+}
+
+// 纹理信息 ({"index": n}) 对应的图片路径，没有纹理时返回空串；图片不是外部文件时失败
+static bool GetTexturePath(const GltfFile& file, const JsonValue* textureInfo, std::string& path)
+{
+    path.clear();
+    if (!textureInfo) return true;
+    const JsonValue& textures = file.Array("textures");
+    int textureIndex = textureInfo->GetInt("index", -1);
+    if (textureIndex < 0 || (size_t)textureIndex >= textures.Size()) return false;
+
+    const JsonValue& images = file.Array("images");
+    int imageIndex = textures[textureIndex].GetInt("source", -1);
+    if (imageIndex < 0 || (size_t)imageIndex >= images.Size()) return false;
+    std::string uri = images[imageIndex].GetString("uri");
+    if (uri.empty() || uri.compare(0, 5, "data:") == 0) return false;
+    path = DecodeUri(uri);
+    return true;
+}
+
+// 材质的纹理：与 Model::processMesh 相同，先漫反射后镜面光，同一路径只记录一次
+static bool CollectMaterialTextures(const GltfFile& file, int materialIndex, std::vector<MeshCache::Image>& images,
+    std::vector<int>& textures)
+{
+    const JsonValue& materials = file.Array("materials");
+    if (materialIndex < 0 || (size_t)materialIndex >= materials.Size()) return true;
+    const JsonValue& material = materials[materialIndex];
+
+    const JsonValue* diffuse = nullptr;
+    const JsonValue* specular = nullptr;
+    const JsonValue* metallicRoughness = material.Find("pbrMetallicRoughness");
+    if (metallicRoughness)
+        diffuse = metallicRoughness->Find("baseColorTexture");
+    const JsonValue* extensions = material.Find("extensions");
+    const JsonValue* specularGlossiness = extensions ? extensions->Find("KHR_materials_pbrSpecularGlossiness") : nullptr;
+    if (specularGlossiness)
+    {
+        if (specularGlossiness->Find("diffuseTexture"))
+            diffuse = specularGlossiness->Find("diffuseTexture");
+        specular = specularGlossiness->Find("specularGlossinessTexture");
+    }
+
+    const JsonValue* slots[2] = { diffuse, specular };
+    const char* typeNames[2] = { "texture_diffuse", "texture_specular" };
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        std::string path;
+        if (!GetTexturePath(file, slots[slot], path)) return false;
+        if (path.empty()) continue;
+
+        int image = -1;
+        for (size_t j = 0; j < images.size(); ++j)
+        {
+            if (images[j].path == path)
+            {
+                image = (int)j;
+                break;
+            }
+        }
+        if (image < 0)
+        {
+            image = (int)images.size();
+            images.push_back(MeshCache::Image{ path, typeNames[slot] });
+        }
+        textures.push_back(image);
+    }
+    return true;
+}
+
+bool GltfLoader::Load(const std::string& path, std::vector<MeshCache::Mesh>& meshes, std::vector<MeshCache::Image>& images,
+    std::vector<std::vector<Vertex>>& vertexArrays, std::vector<std::vector<unsigned int>>& indexArrays)
+{
+    size_t extension = path.find_last_of('.');
+    if (extension == std::string::npos || path.compare(extension, std::string::npos, ".gltf") != 0) return false;
+
+    GltfFile file;
+    {
+        MappedFile text;
+        if (!text.Open(path)) return false;
+        if (!JsonValue::Parse(reinterpret_cast<const char*>(text.GetData()), text.GetSize(), file.document))
+            return false;
+    }
+    size_t slash = path.find_last_of('/');
+    file.directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+
+    // 只处理 glTF 2.0；必需的扩展里只接受材质扩展 (不影响几何数据)
+    const JsonValue* asset = file.document.Find("asset");
+    if (!asset || asset->GetString("version").compare(0, 1, "2") != 0) return false;
+    const JsonValue* required = file.document.Find("extensionsRequired");
+    if (required)
+    {
+        for (size_t i = 0; i < required->Size(); ++i)
+        {
+            if ((*required)[i].AsString().compare(0, 14, "KHR_materials_") != 0)
+                return false;
+        }
+    }
+    // 蒙皮网格的节点变换规则不同，交给 Assimp
+    if (file.Array("skins").Size() > 0) return false;
+
+    // 缓冲：外部 .bin 文件直接映射
+    const JsonValue& buffers = file.Array("buffers");
+    for (size_t i = 0; i < buffers.Size(); ++i)
+    {
+        std::string uri = buffers[i].GetString("uri");
+        if (uri.empty() || uri.compare(0, 5, "data:") == 0) return false;
+        std::unique_ptr<MappedFile> buffer(new MappedFile());
+        if (!buffer->Open(file.directory + '/' + DecodeUri(uri))) return false;
+        if ((size_t)buffers[i].GetNumber("byteLength", 0.0) > buffer->GetSize()) return false;
+        file.buffers.push_back(std::move(buffer));
+    }
+
+    // 场景里的所有图元
+    const JsonValue& scenes = file.Array("scenes");
+    int sceneIndex = file.document.GetInt("scene", 0);
+    if (sceneIndex < 0 || (size_t)sceneIndex >= scenes.Size()) return false;
+    std::vector<PrimitiveInstance> instances;
+    const JsonValue* roots = scenes[sceneIndex].Find("nodes");
+    if (roots)
+    {
+        for (size_t i = 0; i < roots->Size(); ++i)
+        {
+            if (!CollectPrimitives(file, (*roots)[i].AsInt(-1), glm::mat4(1.0f), 0, instances))
+                return false;
+        }
+    }
+
+    // 按材质合并：材质 0..N-1，最后是没有材质的图元
+    int materialCount = (int)file.Array("materials").Size();
+    std::vector<MeshCache::Mesh> resultMeshes;
+    std::vector<MeshCache::Image> resultImages;
+    std::vector<std::vector<Vertex>> resultVertices;
+    std::vector<std::vector<unsigned int>> resultIndices;
+    for (int material = 0; material <= materialCount; ++material)
+    {
+        int key = material < materialCount ? material : -1;
+        std::vector<const PrimitiveInstance*> group;
+        for (const auto& instance : instances)
+        {
+            int primitiveMaterial = instance.primitive->GetInt("material", -1);
+            if (primitiveMaterial < 0 || primitiveMaterial >= materialCount) primitiveMaterial = -1;
+            if (primitiveMaterial == key)
+                group.push_back(&instance);
+        }
+        if (group.empty()) continue;
+
+        MeshCache::Mesh mesh;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        for (const PrimitiveInstance* instance : group)
+        {
+            if (!AppendPrimitive(file, *instance, vertices, indices, mesh.bounds))
+                return false;
+        }
+        if (vertices.empty() || indices.empty()) continue;
+        if (!CollectMaterialTextures(file, key, resultImages, mesh.textures))
+            return false;
+
+        resultMeshes.push_back(mesh);
+        resultVertices.push_back(std::move(vertices));
+        resultIndices.push_back(std::move(indices));
+    }
+    if (resultMeshes.empty()) return false;
+
+    // 数组都生成完之后再取指针
+    for (size_t i = 0; i < resultMeshes.size(); ++i)
+    {
+        resultMeshes[i].vertices = resultVertices[i].data();
+        resultMeshes[i].vertexCount = (uint32_t)resultVertices[i].size();
+        resultMeshes[i].indices = resultIndices[i].data();
+        resultMeshes[i].indexCount = (uint32_t)resultIndices[i].size();
+    }
+
+    meshes = std::move(resultMeshes);
+    images = std::move(resultImages);
+    vertexArrays = std::move(resultVertices);
+    indexArrays = std::move(resultIndices);
+    return true;
+}
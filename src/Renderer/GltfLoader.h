@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MeshCache.h"
+
+struct Vertex;
+
+/*
+GltfLoader: glTF 2.0 的快速导入路径 (不经过 Assimp)
+
+assets/models 下的模型都是 scene.gltf + 外部 scene.bin。这里直接解析 JSON，把 .bin 映射进内存，
+按访问器 (accessor) 的偏移与步长从映射的内存里一次读出位置/法线/纹理坐标，乘上节点的世界变换后
+直接写成交错的 Vertex 数组 (不再经过 aiScene 和逐顶点的中间拷贝)，结果与 Model 原来的 Assimp 后处理一致：
+    - 节点变换预先乘进顶点 (PreTransformVertices)，法线用逆转置矩阵变换后归一化
+    - 同一材质的图元合并成一个网格，按材质顺序输出 (没有材质的图元放在最后)
+    - 纹理坐标保持 glTF 的原始方向 (Assimp 导入时翻转一次、FlipUVs 再翻转回来)
+    - 漫反射贴图取 KHR_materials_pbrSpecularGlossiness 的 diffuseTexture，没有时取 baseColorTexture；
+      镜面光贴图取 specularGlossinessTexture
+
+只处理常见的情况：三角形图元、外部缓冲文件、float 的 POSITION / NORMAL / TEXCOORD_0、8/16/32 位索引。
+遇到其他情况 (几何压缩等必需扩展、稀疏访问器、蒙皮、内嵌图片、缺少法线……) 返回 false，由调用方退回 Assimp。
+*/
+class GltfLoader
+{
+public:
+    // 成功时 meshes 的顶点/索引指向 vertexArrays / indexArrays 里对应的数组
+    static bool Load(const std::string& path, std::vector<MeshCache::Mesh>& meshes, std::vector<MeshCache::Image>& images,
+        std::vector<std::vector<Vertex>>& vertexArrays, std::vector<std::vector<unsigned int>>& indexArrays);
+};
@@ -0,0 +1,198 @@
+﻿#include "LowResParticlePass.h"
+
+LowResParticlePass::LowResParticlePass(int downscale)
+{
+    SetDownscale(downscale);
+}
+
+void LowResParticlePass::SetDownscale(int d)
+{
+    if (d <= 1) downscale = 1;
+    else if (d <= 2) downscale = 2;
+    else downscale = 4;
+
+    // 尺寸随之变化，下一次 Begin 时重建
+    DestroyTargets();
+}
+
+int LowResParticlePass::GetDownscale() const
+{
+    return downscale;
+}
+
+void LowResParticlePass::CreateTargets(int fullWidth, int fullHeight)
+{
+    DestroyTargets();
+
+    width = fullWidth;
+    height = fullHeight;
+    lowWidth = (width + downscale - 1) / downscale;
+    lowHeight = (height + downscale - 1) / downscale;
+
+    // 着色器与空 VAO 只创建一次 (全屏三角形的顶点由 gl_VertexID 生成)
+    if (!depthShader)
+    {
+        depthShader = new Shader("assets/shaders/lowres_fullscreen.vert", "assets/shaders/lowres_depth.frag");
+        compositeShader = new Shader("assets/shaders/lowres_fullscreen.vert", "assets/shaders/lowres_composite.frag");
+        glGenVertexArrays(1, &fullscreenVAO);
+
+        depthShader->use();
+        depthShader->setInt("sceneDepth", 0);
+        downscaleUniform = depthShader->getUniform<int>("downscale");
+        compositeShader->use();
+        compositeShader->setInt("particleColor", 0);
+        compositeShader->setInt("lowDepth", 1);
+        compositeShader->setInt("sceneDepth", 2);
+        lowTexelSizeUniform = compositeShader->getUniform<glm::vec2>("lowTexelSize");
+        nearPlaneUniform = compositeShader->getUniform<float>("nearPlane");
+        farPlaneUniform = compositeShader->getUniform<float>("farPlane");
+    }
+
+    // 全分辨率场景深度：格式与默认帧缓冲 (24 位深度 + 8 位模板) 一致，blit 才能成功
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &depthFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    // 低分辨率粒子目标：RGBA 颜色 (预乘 alpha) + 深度
+    glGenTextures(1, &lowColor);
+    glBindTexture(GL_TEXTURE_2D, lowColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, lowWidth, lowHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &lowDepth);
+    glBindTexture(GL_TEXTURE_2D, lowDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, lowWidth, lowHeight, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &lowFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, lowFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lowColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, lowDepth, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::LOW_RES_PARTICLE_PASS:: Framebuffer is not complete!" << std::endl;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void LowResParticlePass::DestroyTargets()
+{
+    if (depthFBO) glDeleteFramebuffers(1, &depthFBO);
+    if (lowFBO) glDeleteFramebuffers(1, &lowFBO);
+    if (depthTexture) glDeleteTextures(1, &depthTexture);
+    if (lowColor) glDeleteTextures(1, &lowColor);
+    if (lowDepth) glDeleteTextures(1, &lowDepth);
+    depthFBO = lowFBO = depthTexture = lowColor = lowDepth = 0;
+    width = height = 0;
+}
+
+void LowResParticlePass::Release()
+{
+    DestroyTargets();
+    // Shader 没有析构函数，程序对象在这里删除
+    for (Shader** shader : { &depthShader, &compositeShader })
+    {
+        if (*shader)
+        {
+            glDeleteProgram((*shader)->ID);
+            delete *shader;
+            *shader = nullptr;
+        }
+    }
+    if (fullscreenVAO) glDeleteVertexArrays(1, &fullscreenVAO);
+    fullscreenVAO = 0;
+}
+
+void LowResParticlePass::Begin(float nearP, float farP)
+{
+    if (downscale == 1) return;
+
+    // 记下当前的帧缓冲与视口 (一般是默认帧缓冲)，End 时合成回去
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFBO);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (viewport[2] != width || viewport[3] != height)
+        CreateTargets(viewport[2], viewport[3]);
+
+    nearPlane = nearP;
+    farPlane = farP;
+
+    // 1. 解析场景深度 (多重采样的 blit 只能 1:1，不能同时缩放)
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, targetFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    // 2. 降采样到低分辨率深度 (只写深度)
+    glBindFramebuffer(GL_FRAMEBUFFER, lowFBO);
+    glViewport(0, 0, lowWidth, lowHeight);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(GL_ALWAYS);
+    glDepthMask(GL_TRUE);
+
+    depthShader->use();
+    depthShader->set(downscaleUniform, downscale);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glDepthFunc(GL_LESS);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    // 3. 清空颜色，之后的粒子绘制都进入低分辨率目标
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    active = true;
+}
+
+void LowResParticlePass::End()
+{
+    if (!active) return;
+    active = false;
+
+    // 合成回 Begin 时的帧缓冲
+    glBindFramebuffer(GL_FRAMEBUFFER, targetFBO);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    compositeShader->use();
+    compositeShader->set(lowTexelSizeUniform, glm::vec2(1.0f / lowWidth, 1.0f / lowHeight));
+    compositeShader->set(nearPlaneUniform, nearPlane);
+    compositeShader->set(farPlaneUniform, farPlane);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lowColor);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, lowDepth);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../Core/Shader.h"
+
+/*
+LowResParticlePass: 低分辨率离屏粒子绘制
+
+大雪时成千上万片半透明雪花互相重叠，瓶颈在像素填充率上。这个 Pass 把雪 (粒子 + 远景雪层)
+画到 1/downscale 分辨率的离屏目标里，再合成回屏幕：
+    1. Begin: 把当前帧缓冲的场景深度 blit 到一张全分辨率深度纹理 (同时解析掉多重采样)，
+       再降采样成低分辨率深度 (取最近值)，绑定低分辨率目标并清空颜色
+    2. 调用方照常绘制粒子，深度测试针对低分辨率深度，颜色按预乘 alpha 累积
+    3. End: 用深度感知的双边上采样把结果合成回原来的帧缓冲 (GL_ONE, GL_ONE_MINUS_SRC_ALPHA)
+
+downscale 可以是 1/2/4：1 表示不做离屏，Begin/End 都不做任何事，直接画到当前帧缓冲。
+目标尺寸取自 Begin 时的视口，窗口尺寸变化时自动重建。
+*/
+class LowResParticlePass
+{
+public:
+    LowResParticlePass(int downscale = 2);
+
+    // 1 / 2 / 4，其余值会被归到最接近的合法值
+    void SetDownscale(int downscale);
+    int GetDownscale() const;
+
+    // nearPlane/farPlane: 场景深度所用投影的近/远平面 (用于上采样时线性化深度)
+    void Begin(float nearPlane, float farPlane);
+    void End();
+    // 删除离屏目标、着色器与 VAO (OpenGL 上下文销毁之前调用；之后再 Begin 会重新创建)
+    void Release();
+
+private:
+    void CreateTargets(int fullWidth, int fullHeight);
+    void DestroyTargets();
+
+    int downscale;
+    int width = 0, height = 0;          // 全分辨率尺寸
+    int lowWidth = 0, lowHeight = 0;    // 低分辨率尺寸
+    bool active = false;                // Begin 之后、End 之前
+
+    GLint targetFBO = 0;                // Begin 时绑定的帧缓冲，End 时合成回去
+    float nearPlane = 0.1f, farPlane = 100.0f;
+
+    unsigned int depthFBO = 0, depthTexture = 0;            // 全分辨率场景深度
+    unsigned int lowFBO = 0, lowColor = 0, lowDepth = 0;    // 低分辨率粒子目标
+    unsigned int fullscreenVAO = 0;
+
+    Shader* depthShader = nullptr;
+    Shader* compositeShader = nullptr;
+    // 每帧要设置的 uniform (采样器单元在创建着色器时设置一次)
+    Uniform<int> downscaleUniform;
+    Uniform<glm::vec2> lowTexelSizeUniform;
+    Uniform<float> nearPlaneUniform, farPlaneUniform;
+};
@@ -1,80 +1,99 @@
 ﻿#include "Mesh.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, bool keepGeometry)
+    : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures))
 {
-    this->vertices = vertices;
-    this->indices = indices;
-    this->textures = textures;
-
+    assignTextureUnits();
     setupMesh();
+
+    // 数据已经在 GPU 上，不需要时连容量一起释放
+    if (!keepGeometry)
+    {
+        std::vector<Vertex>().swap(this->vertices);
+        std::vector<unsigned int>().swap(this->indices);
+    }
 }
 
-void Mesh::setupMesh()
+Mesh::Mesh(const GeometryRange& geometry, std::vector<Texture> textures)
+    : textures(std::move(textures)), geometry(geometry)
 {
-    // 生成缓冲对象
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    // 加载数据到 VBO
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    assignTextureUnits();
+}
 
-    // 加载数据到 EBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+Mesh::~Mesh()
+{
+    // 只是池的记账，不调用 GL
+    GeometryPool::Get().Free(geometry);
+}
 
-    // 设置顶点属性指针
-    // 1. 位置
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // 2. 法线
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // 3. 纹理坐标
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+Mesh::Mesh(Mesh&& other) noexcept
+    : vertices(std::move(other.vertices)), indices(std::move(other.indices)), textures(std::move(other.textures)),
+      textureUnits(std::move(other.textureUnits)), geometry(other.geometry), bounds(other.bounds)
+{
+    other.geometry = GeometryRange();
+}
 
-    glBindVertexArray(0);
+Mesh& Mesh::operator=(Mesh&& other) noexcept
+{
+    if (this != &other)
+    {
+        GeometryPool::Get().Free(geometry);
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        textures = std::move(other.textures);
+        textureUnits = std::move(other.textureUnits);
+        geometry = other.geometry;
+        bounds = other.bounds;
+        other.geometry = GeometryRange();
+    }
+    return *this;
 }
 
-void Mesh::Draw(Shader& shader)
+void Mesh::setupMesh()
 {
-    // 绑定纹理
-    unsigned int diffuseNr = 1;
-    unsigned int specularNr = 1;
+    // 顶点与索引追加到共享的大缓冲里，网格只记录偏移与数量
+    geometry = GeometryPool::Get().Add(vertices, indices);
+}
 
-    for (unsigned int i = 0; i < textures.size(); i++)
+bool Mesh::SameMaterial(const Mesh& other) const
+{
+    if (textures.size() != other.textures.size()) return false;
+    for (size_t i = 0; i < textures.size(); i++)
     {
-        glActiveTexture(GL_TEXTURE0 + i); // 在绑定之前激活相应的纹理单元
-
-        // 获取纹理序号 (diffuse_textureN)
-        std::string number;
-        std::string name = textures[i].type;
-        if (name == "texture_diffuse")
-            number = std::to_string(diffuseNr++);
-        else if (name == "texture_specular")
-            number = std::to_string(specularNr++); // transfer unsigned int to stream
-        else if (name == "texture_emissive")
-            number = std::to_string(1); // 我们通常只需要一张自发光图
+        if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type)
+            return false;
+    }
+    return true;
+}
 
-        // 设定 shader 中的 uniform 变量 (如: material.texture_diffuse1)
-        // 假设你的 shader 里纹理叫 diffuseTexture，这里可能需要根据 shader 调整
-        // 简单起见，如果只有一个纹理，通常直接传 diffuseTexture
-        shader.setInt((name + number).c_str(), i);
-        // 或者如果你的 shader 写死叫 diffuseTexture，可以用：
-        // if(name == "texture_diffuse") shader.setInt("diffuseTexture", i);
+void Mesh::assignTextureUnits()
+{
+    int diffuseNr = 0;
+    int specularNr = 0;
+    int emissiveNr = 0;
 
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    textureUnits.clear();
+    for (const auto& texture : textures)
+    {
+        int unit = -1;
+        if (texture.type == "texture_diffuse" && diffuseNr < MAX_TEXTURES_PER_TYPE)
+            unit = DIFFUSE_UNIT + diffuseNr++;
+        else if (texture.type == "texture_specular" && specularNr < MAX_TEXTURES_PER_TYPE)
+            unit = SPECULAR_UNIT + specularNr++;
+        else if (texture.type == "texture_emissive" && emissiveNr < 1)
+            unit = EMISSIVE_UNIT + emissiveNr++; // 我们通常只需要一张自发光图
+        textureUnits.push_back(unit);
     }
+}
 
-    // 绘制网格
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    // 恢复默认
-    glActiveTexture(GL_TEXTURE0);
-}
\ No newline at end of file
+void Mesh::SetSamplerUnits(Shader& shader)
+{
+    // 采样器名与 assignTextureUnits 的分配一致 (如 texture_diffuse1 -> 0 号单元)，着色器里没有的名字会被忽略
+    shader.use();
+    for (int n = 1; n <= MAX_TEXTURES_PER_TYPE; ++n)
+    {
+        shader.setInt("texture_diffuse" + std::to_string(n), DIFFUSE_UNIT + n - 1);
+        shader.setInt("texture_specular" + std::to_string(n), SPECULAR_UNIT + n - 1);
+    }
+    shader.setInt("texture_emissive1", EMISSIVE_UNIT);
+}
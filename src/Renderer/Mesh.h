@@ -9,6 +9,8 @@
 
 // 引入 Shader 类，因为 Mesh 需要知道把数据传给哪个 Shader
 #include "../Core/Shader.h" 
+#include "../Core/Collision.h"
+#include "GeometryPool.h"
 
 // 定义顶点结构体
 struct Vertex {
@@ -24,23 +26,43 @@ struct Texture {
     std::string path; // 文件路径，用于防止重复加载
 };
 
+// 网格独占它在几何体池里的范围：只能移动不能拷贝，析构时把范围还给池
 class Mesh {
 public:
-    // 网格数据
+    // 每种纹理固定的纹理单元：texture_diffuseN -> DIFFUSE_UNIT + N - 1，以此类推 (每种最多 MAX_TEXTURES_PER_TYPE 张)
+    // 采样器 uniform 在着色器加载后由 SetSamplerUnits 设置一次，绘制时只需要把纹理绑到对应单元
+    static constexpr int DIFFUSE_UNIT = 0;
+    static constexpr int SPECULAR_UNIT = 4;
+    static constexpr int EMISSIVE_UNIT = 8;
+    static constexpr int MAX_TEXTURES_PER_TYPE = 4;
+
+    // CPU 端的顶点/索引：上传后默认释放，只有构造时要求保留 (碰撞、拾取等) 才有内容
     std::vector<Vertex>       vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture>      textures;
-    unsigned int VAO;
+    std::vector<int>          textureUnits; // textures[i] 绑定的纹理单元 (-1 表示着色器里没有对应的采样器)
+    GeometryRange geometry; // 顶点/索引在几何体池中的位置 (没有自己的 VAO)
+    AABB bounds;    // 模型空间包围盒 (Model::processMesh 中计算)
+
+    // 构造函数：顶点/索引移动进来上传，keepGeometry 为 false 时上传后释放 CPU 端的拷贝
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, bool keepGeometry = false);
+    // 几何体已经上传到池里 (Model 从导入结果或网格缓存直接上传)，网格接管这个范围
+    Mesh(const GeometryRange& geometry, std::vector<Texture> textures);
+    ~Mesh();
 
-    // 构造函数
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&& other) noexcept;
+    Mesh& operator=(Mesh&& other) noexcept;
 
-    // 绘制函数
-    void Draw(Shader& shader);
+    // 把着色器里的材质采样器指向固定的纹理单元 (每个着色器加载后调用一次)
+    static void SetSamplerUnits(Shader& shader);
+    // 是否与另一个网格使用完全相同的纹理 (同一材质)
+    bool SameMaterial(const Mesh& other) const;
 
 private:
-    // 渲染数据
-    unsigned int VBO, EBO;
-    // 初始化缓冲
+    // 上传到几何体池
     void setupMesh();
+    // 按纹理类型分配固定的纹理单元
+    void assignTextureUnits();
 };
\ No newline at end of file
@@ -0,0 +1,310 @@
+﻿#include "MeshCache.h"
+#include "Mesh.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char CACHE_MAGIC[4] = { 'S', 'M', 'S', 'H' };
+static const uint64_t DATA_ALIGNMENT = 16;
+
+// 源文件的大小与修改时间 (不存在的文件全为 0)
+struct SourceStamp
+{
+    uint64_t size;
+    int64_t time;
+};
+
+struct CacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexSize;        // sizeof(Vertex)，顶点结构变化时缓存失效
+    uint32_t meshCount;
+    uint32_t imageCount;
+    uint32_t textureRefCount;
+    uint32_t stringBytes;
+    uint32_t padding0;
+    SourceStamp sources[2];     // 源文件与 glTF 的 .bin
+    uint64_t sourceHash;
+    uint64_t vertexCount;       // 所有网格的顶点总数
+    uint64_t indexCount;
+    uint64_t vertexOffset;      // 顶点段在文件中的位置
+    uint64_t indexOffset;
+    uint64_t fileSize;
+};
+
+struct MeshRecord
+{
+    uint32_t firstVertex, vertexCount;
+    uint32_t firstIndex, indexCount;
+    uint32_t firstTexture, textureCount;
+    float boundsMin[3], boundsMax[3];
+};
+
+struct ImageRecord
+{
+    uint32_t pathOffset, pathLength;
+    uint32_t typeOffset, typeLength;
+};
+
+static uint64_t AlignUp(uint64_t value)
+{
+    return (value + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+}
+
+// 一起决定导入结果的文件：源文件本身，glTF 还有同名的 .bin (顶点数据都在里面)
+static void GetSourceFiles(const std::string& sourcePath, std::string files[2])
+{
+    files[0] = sourcePath;
+    fs::path path(sourcePath);
+    if (path.extension() == ".gltf")
+        files[1] = path.replace_extension(".bin").string();
+}
+
+static SourceStamp GetStamp(const std::string& file)
+{
+    SourceStamp stamp = { 0, 0 };
+    if (file.empty()) return stamp;
+    std::error_code error;
+    uintmax_t size = fs::file_size(file, error);
+    if (error) return stamp;
+    fs::file_time_type time = fs::last_write_time(file, error);
+    if (error) return stamp;
+    stamp.size = (uint64_t)size;
+    stamp.time = (int64_t)time.time_since_epoch().count();
+    return stamp;
+}
+
+// 源文件内容的哈希 (FNV-1a 64)
+static uint64_t HashSources(const std::string files[2])
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < 2; ++i)
+    {
+        MappedFile file;
+        if (files[i].empty() || !file.Open(files[i])) continue;
+        const unsigned char* bytes = file.GetData();
+        for (size_t j = 0; j < file.GetSize(); ++j)
+        {
+            hash ^= bytes[j];
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+bool MeshCache::Read(const std::string& sourcePath, MappedFile& file, std::vector<Mesh>& meshes, std::vector<Image>& images)
+{
+    if (!file.Open(GetCachePath(sourcePath))) return false;
+
+    const unsigned char* base = file.GetData();
+    size_t size = file.GetSize();
+    if (size < sizeof(CacheHeader))
+    {
+        file.Close();
+        return false;
+    }
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    // 格式检查：各段都要落在文件里 (损坏或截断的缓存当作不存在)
+    uint64_t meshTable = sizeof(CacheHeader);
+    uint64_t textureTable = meshTable + (uint64_t)header.meshCount * sizeof(MeshRecord);
+    uint64_t imageTable = textureTable + (uint64_t)header.textureRefCount * sizeof(uint32_t);
+    uint64_t strings = imageTable + (uint64_t)header.imageCount * sizeof(ImageRecord);
+    bool valid = std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+        header.version == VERSION && header.vertexSize == sizeof(Vertex) &&
+        header.fileSize == size &&
+        strings + header.stringBytes <= header.vertexOffset &&
+        header.vertexOffset % DATA_ALIGNMENT == 0 && header.indexOffset % DATA_ALIGNMENT == 0 &&
+        header.vertexOffset + header.vertexCount * sizeof(Vertex) <= header.indexOffset &&
+        header.indexOffset + header.indexCount * sizeof(unsigned int) <= size;
+
+    // 源文件检查：大小与时间一致直接使用，否则比较内容哈希
+    if (valid)
+    {
+        std::string sources[2];
+        GetSourceFiles(sourcePath, sources);
+        for (int i = 0; i < 2; ++i)
+        {
+            SourceStamp stamp = GetStamp(sources[i]);
+            if (stamp.size != header.sources[i].size || stamp.time != header.sources[i].time)
+            {
+                valid = HashSources(sources) == header.sourceHash;
+                break;
+            }
+        }
+    }
+    if (!valid)
+    {
+        file.Close();
+        return false;
+    }
+
+    const Vertex* vertices = reinterpret_cast<const Vertex*>(base + header.vertexOffset);
+    const unsigned int* indices = reinterpret_cast<const unsigned int*>(base + header.indexOffset);
+    const char* stringData = reinterpret_cast<const char*>(base + strings);
+
+    std::vector<Image> readImages(header.imageCount);
+    for (uint32_t i = 0; i < header.imageCount; ++i)
+    {
+        ImageRecord record;
+        std::memcpy(&record, base + imageTable + i * sizeof(ImageRecord), sizeof(record));
+        if ((uint64_t)record.pathOffset + record.pathLength > header.stringBytes ||
+            (uint64_t)record.typeOffset + record.typeLength > header.stringBytes)
+        {
+            file.Close();
+            return false;
+        }
+        readImages[i].path.assign(stringData + record.pathOffset, record.pathLength);
+        readImages[i].type.assign(stringData + record.typeOffset, record.typeLength);
+    }
+
+    std::vector<Mesh> readMeshes(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; ++i)
+    {
+        MeshRecord record;
+        std::memcpy(&record, base + meshTable + i * sizeof(MeshRecord), sizeof(record));
+        if ((uint64_t)record.firstVertex + record.vertexCount > header.vertexCount ||
+            (uint64_t)record.firstIndex + record.indexCount > header.indexCount ||
+            (uint64_t)record.firstTexture + record.textureCount > header.textureRefCount)
+        {
+            file.Close();
+            return false;
+        }
+
+        Mesh& mesh = readMeshes[i];
+        mesh.vertices = vertices + record.firstVertex;
+        mesh.vertexCount = record.vertexCount;
+        mesh.indices = indices + record.firstIndex;
+        mesh.indexCount = record.indexCount;
+        for (uint32_t t = 0; t < record.textureCount; ++t)
+        {
+            uint32_t image;
+            std::memcpy(&image, base + textureTable + (record.firstTexture + t) * sizeof(uint32_t), sizeof(image));
+            if (image >= header.imageCount)
+            {
+                file.Close();
+                return false;
+            }
+            mesh.textures.push_back((int)image);
+        }
+        mesh.bounds = AABB(glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]),
+            glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]));
+    }
+
+    meshes = std::move(readMeshes);
+    images = std::move(readImages);
+    return true;
+}
+
+bool MeshCache::Write(const std::string& sourcePath, const std::vector<Mesh>& meshes, const std::vector<Image>& images)
+{
+    CacheHeader header = {};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.meshCount = (uint32_t)meshes.size();
+    header.imageCount = (uint32_t)images.size();
+
+    std::string sources[2];
+    GetSourceFiles(sourcePath, sources);
+    for (int i = 0; i < 2; ++i)
+        header.sources[i] = GetStamp(sources[i]);
+    header.sourceHash = HashSources(sources);
+
+    // 表与字符串
+    std::vector<MeshRecord> meshRecords(meshes.size());
+    std::vector<uint32_t> textureRefs;
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        const Mesh& mesh = meshes[i];
+        MeshRecord& record = meshRecords[i];
+        record.firstVertex = (uint32_t)header.vertexCount;
+        record.vertexCount = mesh.vertexCount;
+        record.firstIndex = (uint32_t)header.indexCount;
+        record.indexCount = mesh.indexCount;
+        record.firstTexture = (uint32_t)textureRefs.size();
+        record.textureCount = (uint32_t)mesh.textures.size();
+        for (int c = 0; c < 3; ++c)
+        {
+            record.boundsMin[c] = mesh.bounds.min[c];
+            record.boundsMax[c] = mesh.bounds.max[c];
+        }
+        for (int image : mesh.textures)
+            textureRefs.push_back((uint32_t)image);
+        header.vertexCount += mesh.vertexCount;
+        header.indexCount += mesh.indexCount;
+    }
+    header.textureRefCount = (uint32_t)textureRefs.size();
+
+    std::vector<ImageRecord> imageRecords(images.size());
+    std::string stringData;
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        imageRecords[i].pathOffset = (uint32_t)stringData.size();
+        imageRecords[i].pathLength = (uint32_t)images[i].path.size();
+        stringData += images[i].path;
+        imageRecords[i].typeOffset = (uint32_t)stringData.size();
+        imageRecords[i].typeLength = (uint32_t)images[i].type.size();
+        stringData += images[i].type;
+    }
+    header.stringBytes = (uint32_t)stringData.size();
+
+    uint64_t tablesEnd = sizeof(CacheHeader) + meshRecords.size() * sizeof(MeshRecord) +
+        textureRefs.size() * sizeof(uint32_t) + imageRecords.size() * sizeof(ImageRecord) + stringData.size();
+    header.vertexOffset = AlignUp(tablesEnd);
+    header.indexOffset = AlignUp(header.vertexOffset + header.vertexCount * sizeof(Vertex));
+    header.fileSize = header.indexOffset + header.indexCount * sizeof(unsigned int);
+
+    std::string cachePath = GetCachePath(sourcePath);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE:: Cannot write " << tempPath << std::endl;
+            return false;
+        }
+        static const char zeros[DATA_ALIGNMENT] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(meshRecords.data()), meshRecords.size() * sizeof(MeshRecord));
+        out.write(reinterpret_cast<const char*>(textureRefs.data()), textureRefs.size() * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(imageRecords.data()), imageRecords.size() * sizeof(ImageRecord));
+        out.write(stringData.data(), stringData.size());
+        out.write(zeros, header.vertexOffset - tablesEnd);
+        for (const auto& mesh : meshes)
+            out.write(reinterpret_cast<const char*>(mesh.vertices), (std::streamsize)mesh.vertexCount * sizeof(Vertex));
+        out.write(zeros, header.indexOffset - (header.vertexOffset + header.vertexCount * sizeof(Vertex)));
+        for (const auto& mesh : meshes)
+            out.write(reinterpret_cast<const char*>(mesh.indices), (std::streamsize)mesh.indexCount * sizeof(unsigned int));
+        if (!out)
+        {
+            std::cout << "ERROR::MESH_CACHE:: Failed writing " << tempPath << std::endl;
+            out.close();
+            std::error_code error;
+            fs::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(tempPath, cachePath, error);
+    if (error)
+    {
+        std::cout << "ERROR::MESH_CACHE:: Cannot replace " << cachePath << ": " << error.message() << std::endl;
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
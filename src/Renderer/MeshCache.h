@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Core/Collision.h"
+#include "../Core/MappedFile.h"
+
+struct Vertex;
+
+/*
+MeshCache: 烘焙好的网格缓存 (模型文件旁边的 <模型文件名>.meshcache)
+
+Assimp 每次启动都要对同样的文件做一遍三角化、预变换、生成法线等后处理，结果每次都一样。
+第一次加载时把后处理的结果原样写进缓存：交错好的 Vertex 数组、索引、每个网格引用的纹理与包围盒；
+之后的启动直接映射缓存文件，顶点/索引指针指向映射的内存，由几何体池一次 glBufferSubData 上传，不经过 Assimp。
+
+文件布局 (本机字节序，数据段按 16 字节对齐)：
+    Header | MeshRecord × meshCount | 纹理下标 × textureRefCount | ImageRecord × imageCount | 字符串 | 顶点 | 索引
+
+校验：缓存记录了源文件 (以及 glTF 旁边同名的 .bin) 的大小、修改时间和内容哈希。
+大小和时间都一致时直接使用；时间不同 (比如重新检出) 但内容哈希一致时也使用；否则重新导入并覆盖缓存。
+格式或导入参数变化时增加 VERSION，旧缓存自动失效。
+*/
+class MeshCache
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    // 一个网格：vertices / indices 指向映射的缓存文件或调用方自己的数组
+    struct Mesh
+    {
+        const Vertex* vertices = nullptr;
+        uint32_t vertexCount = 0;
+        const unsigned int* indices = nullptr;
+        uint32_t indexCount = 0;
+        std::vector<int> textures;      // 引用的纹理在 images 中的下标
+        AABB bounds;
+    };
+
+    // 材质引用的一张纹理
+    struct Image
+    {
+        std::string path;   // 材质里写的路径 (相对模型目录)
+        std::string type;   // "texture_diffuse" 或 "texture_specular"
+    };
+
+    static std::string GetCachePath(const std::string& sourcePath);
+
+    // 映射 sourcePath 的缓存并校验，成功时 meshes 的顶点/索引指向 file 的映射内存 (file 关闭前有效)
+    static bool Read(const std::string& sourcePath, MappedFile& file, std::vector<Mesh>& meshes, std::vector<Image>& images);
+    // 把导入结果写成缓存 (先写临时文件再替换，写到一半的文件不会被读到)
+    static bool Write(const std::string& sourcePath, const std::vector<Mesh>& meshes, const std::vector<Image>& images);
+};
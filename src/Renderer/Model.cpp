@@ -1,26 +1,372 @@
 ﻿#include "Model.h"
-#include "stb_image.h" // 引用 stb_image
+#include "GltfLoader.h"
+#include "TextureManager.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
 #include <iostream>
+#include <unordered_map>
 
-// 辅助函数：从文件加载纹理
-unsigned int TextureFromFile(const char* path, const std::string& directory);
+// 材质编号从 1 开始，所有模型共用一个计数
+static unsigned int nextMaterialId = 1;
 
-Model::Model(std::string const& path, bool gamma) : gammaCorrection(gamma)
+// 一次加载的全部中间数据：异步加载时由各个任务共享，最后一个任务结束时释放
+struct Model::LoadData
+{
+    std::string directory;
+    std::vector<MeshCache::Mesh> meshes;    // 顶点/索引指向 cacheFile 或下面 Assimp 导入的数组
+    std::vector<MeshCache::Image> images;   // 同一路径只出现一次，类型取第一次引用它的纹理类型
+    MappedFile cacheFile;
+    std::vector<std::vector<Vertex>> importedVertices;
+    std::vector<std::vector<unsigned int>> importedIndices;
+    std::unordered_map<std::string, int> imageIndices;  // Assimp 导入时按路径查 images 的下标
+
+    std::vector<TextureManager::Key> textureKeys;
+    std::vector<DecodedImage> decoded;
+    std::vector<GLuint> textureIds;
+    std::atomic<int> remainingDecodes{ 0 };
+};
+
+// 工作线程：算出纹理的键，全局纹理缓存里还没有时才解码 (文件只映射一次，哈希与解码共用)
+static void decodeTexture(const std::string& filename, TextureManager::Key& key, DecodedImage& image)
+{
+    TextureManager& textures = TextureManager::Get();
+    key = TextureManager::MakeKey(TextureManager::Kind::Material, filename);
+    image.filename = filename;
+    if (textures.Contains(key)) return;
+
+    MappedFile file;
+    if (!file.Open(filename)) return;
+    TextureManager::HashContent(key, file.GetData(), file.GetSize());
+    if (textures.Contains(key)) return;
+    AssetLoader::DecodeImage(filename, file.GetData(), file.GetSize(), image);
+}
+
+// 主线程：缓存里有就增加引用，没有就上传解码结果并登记
+static GLuint acquireTexture(const TextureManager::Key& key, DecodedImage& image)
+{
+    TextureManager& textures = TextureManager::Get();
+    GLuint texture = textures.Acquire(key);
+    if (texture == 0)
+    {
+        // 工作线程跳过解码之后，缓存里的那张纹理又被释放了：在这里补做解码
+        if (!image.pixels)
+            AssetLoader::DecodeImage(image.filename, image);
+        texture = textures.Add(key, AssetLoader::Get().UploadTexture(image),
+            TextureManager::EstimateBytes(image.width, image.height, image.components, true));
+    }
+    image.pixels.reset();
+    return texture;
+}
+
+Model::Model(std::string const& path, bool gamma, bool keepGeometry) : gammaCorrection(gamma), keepGeometry(keepGeometry)
 {
     loadModel(path);
 }
 
-void Model::Draw(Shader& shader)
+Model::Model(std::string const& path, AssetLoader& loader, bool gamma, bool keepGeometry) : gammaCorrection(gamma), keepGeometry(keepGeometry)
+{
+    loader.BeginAsset();
+    std::shared_ptr<LoadData> data = std::make_shared<LoadData>();
+    loader.RunAsync([this, &loader, path, data]() {
+        if (loader.IsCancelled()) return;
+        if (!importModel(path, *data))
+        {
+            loader.RunOnMainThread([this, &loader]() {
+                state = ModelState::Failed;
+                loader.EndAsset();
+            });
+            return;
+        }
+
+        // 每张纹理一个解码任务，最后一个完成的任务负责把上传排到主线程
+        if (data->images.empty())
+        {
+            queueUploads(loader, data);
+            return;
+        }
+        data->remainingDecodes = (int)data->images.size();
+        for (size_t i = 0; i < data->images.size(); i++)
+        {
+            loader.RunAsync([this, &loader, data, i]() {
+                if (loader.IsCancelled()) return;
+                decodeTexture(data->directory + '/' + data->images[i].path, data->textureKeys[i], data->decoded[i]);
+                if (--data->remainingDecodes == 0)
+                    queueUploads(loader, data);
+            });
+        }
+    });
+}
+
+Model::~Model()
+{
+    Release();
+}
+
+Model::Model(Model&& other) noexcept
+    : meshes(std::move(other.meshes)), directory(std::move(other.directory)), textures_loaded(std::move(other.textures_loaded)),
+      bounds(other.bounds), gammaCorrection(other.gammaCorrection), keepGeometry(other.keepGeometry), state(other.state),
+      instanceVBO(other.instanceVBO), materialGroups(std::move(other.materialGroups))
+{
+    other.instanceVBO = 0;
+    other.textures_loaded.clear();
+}
+
+Model& Model::operator=(Model&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        meshes = std::move(other.meshes);
+        directory = std::move(other.directory);
+        textures_loaded = std::move(other.textures_loaded);
+        bounds = other.bounds;
+        gammaCorrection = other.gammaCorrection;
+        keepGeometry = other.keepGeometry;
+        state = other.state;
+        instanceVBO = other.instanceVBO;
+        materialGroups = std::move(other.materialGroups);
+        other.instanceVBO = 0;
+        other.textures_loaded.clear();
+    }
+    return *this;
+}
+
+void Model::Release(GLStateCache* stateCache)
+{
+    // 纹理由全局缓存计引用，别的模型还在用时不会删除
+    for (const auto& texture : textures_loaded)
+        TextureManager::Get().Release(texture.id);
+    if (instanceVBO)
+    {
+        if (stateCache)
+            stateCache->ForgetBuffer(instanceVBO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
+    instanceVBO = 0;
+    textures_loaded.clear();
+    meshes.clear();
+    materialGroups.clear();
+}
+
+bool Model::IsReady() const
+{
+    return state == ModelState::Ready;
+}
+
+ModelState Model::GetState() const
+{
+    return state;
+}
+
+unsigned int Model::Submit(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms)
+{
+    return submitInstances(queue, shader, transforms, nullptr);
+}
+
+unsigned int Model::Submit(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms, const Frustum& frustum)
 {
+    return submitInstances(queue, shader, transforms, &frustum);
+}
+
+unsigned int Model::submitInstances(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms, const Frustum* frustum)
+{
+    if (transforms.empty()) return 0;
+
+    if (instanceVBO == 0)
+        glGenBuffers(1, &instanceVBO);
+
+    // 每次都重新分配 (orphan)，同一帧里阴影 Pass 与主 Pass 上传不同的实例不会互相等待
+    // (队列在每个 Pass 结束时就执行完，不会有两份实例数据同时等待绘制)
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(glm::mat4), transforms.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // 排序用的深度：离相机最近的实例包围盒到相机的距离
+    float depth = FLT_MAX;
+    for (const auto& transform : transforms)
+    {
+        AABB world = TransformAABB(bounds, transform);
+        glm::vec3 closest = glm::clamp(queue.GetEye(), world.min, world.max);
+        depth = std::min(depth, glm::length(closest - queue.GetEye()));
+    }
+
+    // 提交参数 (只在主线程使用)
+    static std::vector<GLsizei> counts;
+    static std::vector<const void*> offsets;
+    static std::vector<GLint> baseVertices;
+
+    GeometryPool& pool = GeometryPool::Get();
+    unsigned int commands = 0;
+    for (const auto& group : materialGroups)
+    {
+        counts.clear();
+        offsets.clear();
+        baseVertices.clear();
+        for (unsigned int index : group.meshIndices)
+        {
+            const Mesh& mesh = meshes[index];
+            if (frustum)
+            {
+                // 网格在所有实例下都不与视锥相交时跳过
+                bool visible = false;
+                for (const auto& transform : transforms)
+                {
+                    if (frustum->TestAABB(TransformAABB(mesh.bounds, transform)) != CullResult::Outside)
+                    {
+                        visible = true;
+                        break;
+                    }
+                }
+                if (!visible) continue;
+            }
+            counts.push_back(mesh.geometry.indexCount);
+            offsets.push_back((const void*)(sizeof(unsigned int) * mesh.geometry.firstIndex));
+            baseVertices.push_back(mesh.geometry.baseVertex);
+        }
+        if (counts.empty()) continue;
+
+        RenderCommand command;
+        command.shader = &shader;
+        command.material = &meshes[group.meshIndices[0]];
+        command.materialId = group.materialId;
+        command.vertexArray = pool.GetVertexArray(group.page);
+        command.instanceBuffer = instanceVBO;
+        command.instanceCount = (GLsizei)transforms.size();
+        command.depth = depth;
+        // 绘制物体时关闭面剔除，让树叶双面可见
+        command.cullFace = false;
+        queue.Submit(command, counts.data(), offsets.data(), baseVertices.data(), (int)counts.size());
+        ++commands;
+    }
+    return commands;
+}
+
+void Model::buildMaterialGroups()
+{
+    materialGroups.clear();
     for (unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].Draw(shader);
+    {
+        MaterialGroup* target = nullptr;
+        for (auto& group : materialGroups)
+        {
+            if (group.page == meshes[i].geometry.page && meshes[group.meshIndices[0]].SameMaterial(meshes[i]))
+            {
+                target = &group;
+                break;
+            }
+        }
+        if (!target)
+        {
+            materialGroups.push_back(MaterialGroup{ meshes[i].geometry.page, nextMaterialId++, {} });
+            target = &materialGroups.back();
+        }
+        target->meshIndices.push_back(i);
+    }
 }
 
 void Model::loadModel(std::string const& path)
+{
+    LoadData data;
+    if (!importModel(path, data))
+    {
+        state = ModelState::Failed;
+        return;
+    }
+
+    for (size_t i = 0; i < data.images.size(); i++)
+    {
+        decodeTexture(data.directory + '/' + data.images[i].path, data.textureKeys[i], data.decoded[i]);
+        data.textureIds[i] = acquireTexture(data.textureKeys[i], data.decoded[i]);
+    }
+    finishLoading(data);
+}
+
+void Model::queueUploads(AssetLoader& loader, std::shared_ptr<LoadData> data)
+{
+    // 纹理分开上传，一帧的预算用完时剩下的留到下一帧
+    for (size_t i = 0; i < data->images.size(); i++)
+    {
+        loader.RunOnMainThread([data, i]() {
+            data->textureIds[i] = acquireTexture(data->textureKeys[i], data->decoded[i]);
+        });
+    }
+    loader.RunOnMainThread([this, &loader, data]() {
+        finishLoading(*data);
+        loader.EndAsset();
+    });
+}
+
+void Model::finishLoading(LoadData& data)
+{
+    directory = data.directory;
+
+    for (size_t i = 0; i < data.images.size(); i++)
+    {
+        Texture texture;
+        texture.id = data.textureIds[i];
+        texture.type = data.images[i].type;
+        texture.path = data.images[i].path;
+        textures_loaded.push_back(texture);
+    }
+
+    // 顶点/索引直接从缓存文件的映射 (或导入的数组) 上传到几何体池；要求保留几何体时才在网格里留一份拷贝
+    GeometryPool& pool = GeometryPool::Get();
+    meshes.reserve(data.meshes.size());
+    for (const auto& meshData : data.meshes)
+    {
+        std::vector<Texture> textures;
+        for (int image : meshData.textures)
+            textures.push_back(textures_loaded[image]);
+        if (keepGeometry)
+        {
+            meshes.emplace_back(std::vector<Vertex>(meshData.vertices, meshData.vertices + meshData.vertexCount),
+                std::vector<unsigned int>(meshData.indices, meshData.indices + meshData.indexCount), std::move(textures), true);
+        }
+        else
+        {
+            GeometryRange geometry = pool.Add(meshData.vertices, (GLsizei)meshData.vertexCount,
+                meshData.indices, (GLsizei)meshData.indexCount);
+            meshes.emplace_back(geometry, std::move(textures));
+        }
+        meshes.back().bounds = meshData.bounds;
+    }
+
+    // 模型包围盒 = 所有网格包围盒的并
+    for (unsigned int i = 0; i < meshes.size(); i++)
+        bounds = i == 0 ? meshes[i].bounds : MergeAABB(bounds, meshes[i].bounds);
+
+    // 按材质分组，绘制时每组只绑定一次纹理、尽量一次提交
+    buildMaterialGroups();
+    state = ModelState::Ready;
+}
+
+bool Model::importModel(std::string const& path, LoadData& data)
+{
+    // 获取文件夹路径
+    data.directory = path.substr(0, path.find_last_of('/'));
+
+    // 有有效的网格缓存时直接映射；否则常见的 glTF 走快速路径，其余交给 Assimp
+    if (!MeshCache::Read(path, data.cacheFile, data.meshes, data.images))
+    {
+        if (!GltfLoader::Load(path, data.meshes, data.images, data.importedVertices, data.importedIndices) &&
+            !importScene(path, data))
+            return false;
+        MeshCache::Write(path, data.meshes, data.images);
+    }
+
+    data.textureKeys.resize(data.images.size());
+    data.decoded.resize(data.images.size());
+    data.textureIds.resize(data.images.size(), 0);
+    return true;
+}
+
+bool Model::importScene(std::string const& path, LoadData& data)
 {
     Assimp::Importer importer;
     // 读取文件：三角化(Triangulate) | 翻转UV(FlipUVs)
     // const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    // (改动后处理参数时要增加 MeshCache::VERSION，让旧的网格缓存失效)
 
     const aiScene* scene = importer.ReadFile(path,
         aiProcess_Triangulate |
@@ -33,34 +379,43 @@ void Model::loadModel(std::string const& path)
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
         std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-        return;
+        return false;
     }
-    // 获取文件夹路径
-    directory = path.substr(0, path.find_last_of('/'));
 
-    processNode(scene->mRootNode, scene);
+    processNode(scene->mRootNode, scene, data);
+
+    // 数组都生成完之后再取指针
+    for (size_t i = 0; i < data.meshes.size(); i++)
+    {
+        data.meshes[i].vertices = data.importedVertices[i].data();
+        data.meshes[i].vertexCount = (uint32_t)data.importedVertices[i].size();
+        data.meshes[i].indices = data.importedIndices[i].data();
+        data.meshes[i].indexCount = (uint32_t)data.importedIndices[i].size();
+    }
+    return true;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::processNode(aiNode* node, const aiScene* scene, LoadData& data)
 {
     // 处理当前节点的所有网格
     for (unsigned int i = 0; i < node->mNumMeshes; i++)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        processMesh(mesh, scene, data);
     }
     // 递归处理子节点
     for (unsigned int i = 0; i < node->mNumChildren; i++)
     {
-        processNode(node->mChildren[i], scene);
+        processNode(node->mChildren[i], scene, data);
     }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+void Model::processMesh(aiMesh* mesh, const aiScene* scene, LoadData& data)
 {
+    MeshCache::Mesh result;
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
+    std::vector<int>& textures = result.textures;
 
     // 1. 处理顶点
     for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -89,6 +444,17 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
         vertices.push_back(vertex);
     }
 
+    // 网格包围盒 (aiProcess_PreTransformVertices 之后顶点已经在模型空间)
+    if (!vertices.empty())
+    {
+        result.bounds = AABB(vertices[0].Position, vertices[0].Position);
+        for (const auto& vertex : vertices)
+        {
+            result.bounds.min = glm::min(result.bounds.min, vertex.Position);
+            result.bounds.max = glm::max(result.bounds.max, vertex.Position);
+        }
+    }
+
     // 2. 处理索引
     for (unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
@@ -101,112 +467,41 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
     // 1. 漫反射贴图
-    //std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-    std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+    std::vector<int> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data);
     // 【新增】如果是 glTF 模型，材质可能存放在 BASE_COLOR 里，我们补救一下
     if (diffuseMaps.empty()) {
-        std::vector<Texture> baseColorMaps = loadMaterialTextures(material, aiTextureType_BASE_COLOR, "texture_diffuse");
+        std::vector<int> baseColorMaps = loadMaterialTextures(material, aiTextureType_BASE_COLOR, "texture_diffuse", data);
         diffuseMaps.insert(diffuseMaps.end(), baseColorMaps.begin(), baseColorMaps.end());
     }
     textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
     // 2. 镜面光贴图
-    std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+    std::vector<int> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data);
     textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
-    return Mesh(vertices, indices, textures);
+    data.meshes.push_back(result);
+    data.importedVertices.push_back(std::move(vertices));
+    data.importedIndices.push_back(std::move(indices));
 }
 
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+std::vector<int> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, LoadData& data)
 {
-    std::vector<Texture> textures;
+    std::vector<int> textures;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
 
         // 检查是否已经加载过
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++)
-        {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-            {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break;
-            }
-        }
-        if (!skip)
+        auto found = data.imageIndices.find(str.C_Str());
+        if (found != data.imageIndices.end())
         {
-            Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
-            texture.type = typeName;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            textures_loaded.push_back(texture);
+            textures.push_back(found->second);
+            continue;
         }
+        int index = (int)data.images.size();
+        data.imageIndices.emplace(str.C_Str(), index);
+        textures.push_back(index);
+        data.images.push_back(MeshCache::Image{ str.C_Str(), typeName });
     }
     return textures;
 }
-
-unsigned int TextureFromFile(const char* path, const std::string& directory)
-{
-    std::string filename = std::string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        // 【修复】给 format 一个默认值 GL_RGB，防止未初始化报错
-        GLenum format = GL_RGB;
-
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 2)  // 【新增】处理 2 通道 (GL_RG)
-            format = GL_RG;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // ==========================================================
-        //  针对灰度图 (1通道) 和 灰度透明图 (2通道) 的颜色修正
-        // ==========================================================
-        if (format == GL_RED)
-        {
-            // 如果是单通道(R)，让 G 和 B 也等于 R
-            // 结果：红色 -> 灰色/白色
-            GLint swizzleMask[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
-            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
-        }
-        else if (format == GL_RG)
-        {
-            // 如果是双通道(R, G)，通常 R 是灰度，G 是透明度(Alpha)
-            // 我们让 G, B 都等于 R，但是让 Alpha 等于 G
-            GLint swizzleMask[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
-            glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
-        }
-        // ==========================================================
-        // ... 设置参数 ...
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << filename << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
\ No newline at end of file
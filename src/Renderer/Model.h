@@ -11,35 +11,101 @@
 
 #include "Mesh.h"
 #include "../Core/Shader.h"
+#include "../Core/Collision.h"
+#include "../Core/Culling.h"
+#include "RenderQueue.h"
+#include "AssetLoader.h"
+#include "MeshCache.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
+// 模型的加载状态：异步加载的模型在 Ready 之前没有网格，提交时什么也不画
+enum class ModelState
+{
+    Pending,
+    Ready,
+    Failed
+};
+
+// 模型拥有自己的网格、实例缓冲和纹理的引用：只能移动不能拷贝。
+// GL 对象在 Release (或析构) 时删除，所以要在 OpenGL 上下文销毁之前调用 Release
 class Model
 {
 public:
     // 存储所有的网格
     std::vector<Mesh> meshes;
     std::string directory;
-    std::vector<Texture> textures_loaded; // 缓存已加载的纹理
+    std::vector<Texture> textures_loaded; // 模型用到的纹理 (每张在 TextureManager 里持有一次引用)
+    AABB bounds;                          // 模型空间包围盒 (加载时由所有顶点计算，用于剔除)
 
     // 构造函数：直接传入路径加载
-    Model(std::string const& path, bool gamma = false);
+    // keepGeometry: 上传后在各个网格里保留 CPU 端的顶点/索引 (碰撞、拾取需要时才打开)
+    Model(std::string const& path, bool gamma = false, bool keepGeometry = false);
+    // 异步加载：导入与纹理解码在 loader 的工作线程上执行，纹理与网格的上传在主线程的 loader.Update 中完成，
+    // 之后 IsReady 变为 true。模型在 loader.Stop 之前不能销毁 (也不能移动)
+    Model(std::string const& path, AssetLoader& loader, bool gamma = false, bool keepGeometry = false);
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&& other) noexcept;
+    Model& operator=(Model&& other) noexcept;
+
+    // 释放纹理引用、删除实例缓冲并清空网格 (可以重复调用)
+    // stateCache: 提交时用的状态缓存，让它忘掉实例缓冲 (析构时不传，缓存在下一次 BeginFrame 时清除)
+    void Release(GLStateCache* stateCache = nullptr);
+
+    bool IsReady() const;
+    ModelState GetState() const;
 
-    // 绘制模型
-    void Draw(Shader& shader);
+    // 实例化提交：transforms 里每个模型矩阵画一个实例，上传实例缓冲后每个材质组向队列提交一条命令
+    // (只有一个实例时整组用一次 glMultiDrawElementsBaseVertex 执行)。返回提交的命令数
+    unsigned int Submit(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms);
+    // 带视锥剔除的提交：网格在所有实例下都不与视锥相交时跳过
+    unsigned int Submit(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms, const Frustum& frustum);
 
 private:
     bool gammaCorrection;
-    // 加载模型函数
+    bool keepGeometry;
+    ModelState state = ModelState::Pending;
+    unsigned int instanceVBO = 0;   // 所有网格共用的实例缓冲 (第一次实例化绘制时创建)
+
+    // 材质相同且在几何体池同一页里的网格 (加载完成后分组)
+    struct MaterialGroup
+    {
+        int page;
+        unsigned int materialId;    // 全局唯一的材质编号 (排序键用)
+        std::vector<unsigned int> meshIndices;
+    };
+    std::vector<MaterialGroup> materialGroups;
+
+    void buildMaterialGroups();
+
+    // 上传实例矩阵并按材质组提交，frustum 为空时不剔除
+    unsigned int submitInstances(RenderQueue& queue, Shader& shader, const std::vector<glm::mat4>& transforms, const Frustum* frustum);
+    // 导入结果 (只有 CPU 端数据，工作线程上生成，定义在 Model.cpp)
+    struct LoadData;
+
+    // 加载模型函数：导入、解码纹理并上传 (同步)
     void loadModel(std::string const& path);
+    // 纹理解码完成后把上传与收尾排到主线程 (每张纹理一个任务，最后创建网格)
+    void queueUploads(AssetLoader& loader, std::shared_ptr<LoadData> data);
+    // 创建网格 (上传到几何体池)、计算包围盒并按材质分组 (主线程，纹理已经上传)
+    void finishLoading(LoadData& data);
+
+    // 读取网格缓存，没有有效的缓存时用 Assimp 导入并写缓存；只生成 CPU 端的数据 (可以在工作线程上执行)
+    static bool importModel(std::string const& path, LoadData& data);
+    // 用 Assimp 读取文件
+    static bool importScene(std::string const& path, LoadData& data);
 
     // 递归处理节点
-    void processNode(aiNode* node, const aiScene* scene);
+    static void processNode(aiNode* node, const aiScene* scene, LoadData& data);
 
-    // 将 Assimp 的 mesh 转换为我们的 Mesh
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+    // 将 Assimp 的 mesh 转换为网格数据
+    static void processMesh(aiMesh* mesh, const aiScene* scene, LoadData& data);
 
-    // 加载材质纹理
-    std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+    // 收集材质纹理，返回它们在 data.images 中的下标 (同一路径只解码一次)
+    static std::vector<int> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, LoadData& data);
 };
\ No newline at end of file
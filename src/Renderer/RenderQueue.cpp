@@ -0,0 +1,128 @@
+﻿#include "RenderQueue.h"
+#include "Mesh.h"
+
+#include <algorithm>
+
+uint64_t RenderQueue::MakeKey(RenderPass pass, GLuint program, unsigned int materialId, float normalizedDepth)
+{
+    uint64_t depthBits = (uint64_t)(std::min(std::max(normalizedDepth, 0.0f), 1.0f) * 65535.0f);
+    return ((uint64_t)pass & 0xF) << 60 |
+        ((uint64_t)program & 0xFFF) << 48 |
+        ((uint64_t)materialId & 0xFFFFF) << 28 |
+        depthBits << 12;
+}
+
+void RenderQueue::Begin(RenderPass renderPass, const glm::vec3& eyePosition, float far)
+{
+    pass = renderPass;
+    eye = eyePosition;
+    farPlane = std::max(far, 1e-3f);
+    entries.clear();
+    counts.clear();
+    offsets.clear();
+    baseVertices.clear();
+}
+
+void RenderQueue::Submit(const RenderCommand& command, const GLsizei* drawCounts, const void* const* drawOffsets,
+    const GLint* drawBaseVertices, int drawCount)
+{
+    if (drawCount <= 0 || command.instanceCount <= 0) return;
+
+    Entry entry;
+    entry.key = MakeKey(pass, command.shader->ID, command.materialId, command.depth / farPlane);
+    entry.command = command;
+    entry.firstDraw = (unsigned int)counts.size();
+    entry.drawCount = (unsigned int)drawCount;
+    counts.insert(counts.end(), drawCounts, drawCounts + drawCount);
+    offsets.insert(offsets.end(), drawOffsets, drawOffsets + drawCount);
+    baseVertices.insert(baseVertices.end(), drawBaseVertices, drawBaseVertices + drawCount);
+    entries.push_back(entry);
+}
+
+unsigned int RenderQueue::Execute(GLStateCache& cache)
+{
+    order.resize(entries.size());
+    for (unsigned int i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [this](unsigned int a, unsigned int b) { return entries[a].key < entries[b].key; });
+
+    unsigned int drawCalls = 0;
+    usedShaders.clear();
+
+    for (unsigned int index : order)
+    {
+        const Entry& entry = entries[index];
+        const RenderCommand& command = entry.command;
+        Shader& shader = *command.shader;
+
+        cache.UseProgram(shader.ID);
+        // 模型矩阵取实例属性：每个程序只设置一次，执行完再统一改回去
+        if (std::find(usedShaders.begin(), usedShaders.end(), &shader) == usedShaders.end())
+        {
+            auto it = instancedUniforms.find(&shader);
+            if (it == instancedUniforms.end())
+                it = instancedUniforms.emplace(&shader, shader.getUniform<bool>("instanced")).first;
+            shader.set(it->second, true);
+            usedShaders.push_back(&shader);
+        }
+
+        cache.SetCullFace(command.cullFace);
+        cache.SetBlend(command.blend);
+        cache.SetDepthTest(true);
+
+        // 材质：采样器固定在各自的纹理单元上 (Mesh::SetSamplerUnits)，这里只绑定纹理，经过缓存
+        if (command.material)
+        {
+            const std::vector<Texture>& textures = command.material->textures;
+            const std::vector<int>& units = command.material->textureUnits;
+            for (unsigned int i = 0; i < textures.size(); i++)
+            {
+                if (units[i] >= 0)
+                    cache.BindTexture(units[i], GL_TEXTURE_2D, textures[i].id);
+            }
+        }
+
+        cache.BindVertexArray(command.vertexArray);
+        cache.SetInstanceBuffer(command.instanceBuffer);
+
+        if (command.instanceCount == 1)
+        {
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, &counts[entry.firstDraw], GL_UNSIGNED_INT,
+                &offsets[entry.firstDraw], (GLsizei)entry.drawCount, &baseVertices[entry.firstDraw]);
+            ++drawCalls;
+        }
+        else
+        {
+            // 多实例没有对应的 multi-draw (GL 3.3 没有间接绘制)，逐网格实例化绘制
+            for (unsigned int k = entry.firstDraw; k < entry.firstDraw + entry.drawCount; ++k)
+            {
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, counts[k], GL_UNSIGNED_INT, offsets[k],
+                    command.instanceCount, baseVertices[k]);
+                ++drawCalls;
+            }
+        }
+    }
+
+    // 其它使用同一个着色器的绘制 (空气墙线框) 仍然走 model uniform
+    for (Shader* shader : usedShaders)
+    {
+        cache.UseProgram(shader->ID);
+        shader->set(instancedUniforms[shader], false);
+    }
+    // 队列之外的代码假设活动纹理单元是 0
+    cache.ActiveTexture(0);
+
+    entries.clear();
+    return drawCalls;
+}
+
+const glm::vec3& RenderQueue::GetEye() const
+{
+    return eye;
+}
+
+size_t RenderQueue::GetCommandCount() const
+{
+    return entries.size();
+}
@@ -0,0 +1,89 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+#include "../Core/Shader.h"
+
+class Mesh;
+
+/*
+RenderQueue: 按 64 位排序键提交的绘制队列
+
+每个 Pass 先 Begin，然后把所有绘制命令 Submit 进来 (Model::Submit 每个材质组一条命令)，
+最后 Execute：按排序键排序后依次执行，所有状态切换都经过 GLStateCache，相同的状态不会重复设置。
+
+排序键 (从高位到低位)：
+    [63..60] Pass          不同 Pass 的命令不会交错
+    [59..48] 着色器程序     同一个程序的命令排在一起，减少 glUseProgram
+    [47..28] 材质           同一套纹理的命令排在一起，减少纹理绑定
+    [27..12] 深度           不透明物体从近到远 (尽量利用 Early-Z)
+    [11..0]  保留
+键相同的命令保持提交顺序。
+*/
+
+// 排序键里的 Pass (数值越小越先画)
+enum class RenderPass : uint8_t
+{
+    Depth = 0,      // 只写深度 (阴影、降雪遮挡)
+    Opaque = 1,     // 不透明物体
+};
+
+// 一条绘制命令：同一页几何体、同一材质的若干个网格，一起按实例数绘制
+struct RenderCommand
+{
+    Shader* shader = nullptr;
+    const Mesh* material = nullptr;     // 取它的纹理作为材质
+    unsigned int materialId = 0;        // 材质编号 (排序用，相同纹理的命令编号相同)
+    GLuint vertexArray = 0;             // 几何体池某一页的 VAO
+    GLuint instanceBuffer = 0;          // 实例缓冲 (每个实例一个 mat4)
+    GLsizei instanceCount = 1;
+    float depth = 0.0f;                 // 到相机的距离 (排序用)
+    bool cullFace = false;              // 树叶等双面材质需要关闭面剔除
+    bool blend = false;
+};
+
+class RenderQueue
+{
+public:
+    // 开始一个 Pass：清空队列；eye/farPlane 用于把深度量化进排序键
+    void Begin(RenderPass pass, const glm::vec3& eye, float farPlane);
+
+    // 提交一条命令，counts/offsets/baseVertices 是 drawCount 个网格在几何体池中的索引数、索引偏移 (字节) 与顶点起点
+    void Submit(const RenderCommand& command, const GLsizei* counts, const void* const* offsets,
+        const GLint* baseVertices, int drawCount);
+
+    // 排序并执行，返回发出的 DrawCall 数
+    unsigned int Execute(GLStateCache& cache);
+
+    const glm::vec3& GetEye() const;
+    size_t GetCommandCount() const;
+
+    static uint64_t MakeKey(RenderPass pass, GLuint program, unsigned int materialId, float normalizedDepth);
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        RenderCommand command;
+        unsigned int firstDraw;     // 在 counts/offsets/baseVertices 中的起点
+        unsigned int drawCount;
+    };
+
+    RenderPass pass = RenderPass::Opaque;
+    glm::vec3 eye = glm::vec3(0.0f);
+    float farPlane = 1.0f;
+
+    std::vector<Entry> entries;
+    std::vector<unsigned int> order;
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    std::vector<Shader*> usedShaders;   // Execute 中设置过 instanced 的程序
+    // 每个程序的 instanced uniform 位置 (第一次遇到时解析，之后不再按名字查找)
+    std::unordered_map<const Shader*, Uniform<bool>> instancedUniforms;
+};
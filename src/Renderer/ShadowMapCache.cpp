@@ -0,0 +1,264 @@
+﻿#include "ShadowMapCache.h"
+#include "../Core/Culling.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// 级联拟合时在外接球外面留的余量：相机在余量内移动/转动时不用重画这一级
+static const float CACHE_MARGIN = 0.15f;
+// 光源方向上额外向太阳一侧延伸的距离，切片以外但挡在太阳与切片之间的物体 (房子、树) 也能投下阴影
+static const float CASTER_EXTENSION = 100.0f;
+// 投影到阴影图上小于这么多个纹素的投射物直接跳过
+static const float MIN_CASTER_TEXELS = 1.5f;
+
+// 光空间的朝向：从太阳看向场景，太阳接近正上方时换一个 up 防止 lookAt 退化
+static glm::vec3 LightUp(const glm::vec3& direction)
+{
+    return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+ShadowMapCache::ShadowMapCache(int resolution, int cascadeCount, float angleThresholdDegrees)
+    : resolution(resolution), cascadeCount(std::min(std::max(cascadeCount, 2), MAX_CASCADES))
+{
+    SetAngleThreshold(angleThresholdDegrees);
+}
+
+void ShadowMapCache::Init()
+{
+    if (depthTexture != 0) return;
+
+    // 所有级联放在同一个纹理数组里，basic.frag 用一个 sampler2DArray 采样
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, cascadeCount, 0,
+        GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    // 设置纹理环绕 (防止阴影以外的区域变黑)
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+    // 保存当前绑定的帧缓冲，创建完后恢复
+    GLint previousFBO = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFBO);
+
+    // 每个级联一个 FBO，深度附件是纹理数组的一层
+    for (int i = 0; i < cascadeCount; ++i)
+    {
+        glGenFramebuffers(1, &cascades[i].fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, cascades[i].fbo);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, i);
+        glDrawBuffer(GL_NONE); // 不需要颜色
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::SHADOW_MAP_CACHE:: Framebuffer is not complete!" << std::endl;
+        cascades[i].valid = false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+}
+
+void ShadowMapCache::SetShadowDistance(float distance)
+{
+    shadowDistance = distance;
+    Invalidate();
+}
+
+void ShadowMapCache::SetSplitLambda(float lambda)
+{
+    splitLambda = std::min(std::max(lambda, 0.0f), 1.0f);
+    Invalidate();
+}
+
+void ShadowMapCache::SetAngleThreshold(float degrees)
+{
+    cosThreshold = std::cos(glm::radians(std::max(degrees, 0.0f)));
+}
+
+void ShadowMapCache::Invalidate()
+{
+    for (auto& cascade : cascades)
+        cascade.valid = false;
+}
+
+unsigned int ShadowMapCache::Update(const glm::mat4& view, float fovY, float aspect, float nearPlane,
+    const glm::vec3& lightDirection, size_t casterHash)
+{
+    glm::vec3 direction = glm::normalize(lightDirection);
+    glm::mat4 invView = glm::inverse(view);
+    float tanY = std::tan(fovY * 0.5f);
+    float tanX = tanY * aspect;
+
+    unsigned int dirtyMask = 0;
+    float sliceNear = nearPlane;
+    for (int i = 0; i < cascadeCount; ++i)
+    {
+        // 切分距离：对数切分 (近处更密) 与均匀切分按 splitLambda 混合
+        float p = (float)(i + 1) / (float)cascadeCount;
+        float logSplit = nearPlane * std::pow(shadowDistance / nearPlane, p);
+        float uniformSplit = nearPlane + (shadowDistance - nearPlane) * p;
+        float sliceFar = splitLambda * logSplit + (1.0f - splitLambda) * uniformSplit;
+        splits[i] = sliceFar;
+
+        // 切片的 8 个角 (世界空间) 与外接球
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        int k = 0;
+        for (float d : { sliceNear, sliceFar })
+        {
+            for (int sx = -1; sx <= 1; sx += 2)
+            {
+                for (int sy = -1; sy <= 1; sy += 2)
+                {
+                    corners[k] = glm::vec3(invView * glm::vec4(sx * tanX * d, sy * tanY * d, -d, 1.0f));
+                    center += corners[k];
+                    ++k;
+                }
+            }
+        }
+        center /= 8.0f;
+        float radius = 0.0f;
+        for (const auto& corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+        // 半径只取决于切片形状，取整后不受浮点误差影响，纹素大小保持稳定
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        Cascade& cascade = cascades[i];
+        bool rebuild = !cascade.valid || cascade.casterHash != casterHash ||
+            glm::dot(direction, cascade.direction) < cosThreshold;
+        if (!rebuild)
+        {
+            // 当前切片在光空间 XY 平面上是否仍在已绘制的范围内
+            glm::vec3 forward = -cascade.direction;
+            glm::vec3 right = glm::normalize(glm::cross(forward, LightUp(cascade.direction)));
+            glm::vec3 up = glm::cross(right, forward);
+            glm::vec3 offset = center - cascade.center;
+            float reach = std::max(std::abs(glm::dot(offset, right)), std::abs(glm::dot(offset, up))) + radius;
+            // 超出范围要重画；视野变窄 (缩放) 很多时也重画，换回更高的纹素密度
+            rebuild = reach > cascade.halfExtent || radius * (1.0f + CACHE_MARGIN) * 1.5f < cascade.halfExtent;
+        }
+
+        if (rebuild)
+        {
+            FitCascade(cascade, center, radius, direction);
+            cascade.casterHash = casterHash;
+            cascade.valid = true;
+            dirtyMask |= 1u << i;
+            ++rebuildCount;
+        }
+        sliceNear = sliceFar;
+    }
+    return dirtyMask;
+}
+
+void ShadowMapCache::FitCascade(Cascade& cascade, const glm::vec3& center, float radius, const glm::vec3& direction) const
+{
+    glm::vec3 up = LightUp(direction);
+    float halfExtent = radius * (1.0f + CACHE_MARGIN);
+    float texel = 2.0f * halfExtent / (float)resolution;
+
+    // 中心在光空间中对齐到纹素网格：重建前后同一世界位置落在同一个纹素上，阴影边缘不闪烁
+    glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), -direction, up);
+    glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+    lightCenter.x = std::floor(lightCenter.x / texel) * texel;
+    lightCenter.y = std::floor(lightCenter.y / texel) * texel;
+    glm::vec3 snapped = glm::vec3(glm::inverse(lightRotation) * glm::vec4(lightCenter, 1.0f));
+
+    float depthRange = 2.0f * halfExtent + CASTER_EXTENSION;
+    glm::vec3 eye = snapped + direction * (halfExtent + CASTER_EXTENSION);
+    glm::mat4 lightView = glm::lookAt(eye, snapped, up);
+    glm::mat4 lightProjection = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, 0.0f, depthRange);
+
+    cascade.center = snapped;
+    cascade.halfExtent = halfExtent;
+    cascade.depthRange = depthRange;
+    cascade.direction = direction;
+    cascade.lightSpaceMatrix = lightProjection * lightView;
+    cascade.cullStats = ShadowCullStats();
+}
+
+bool ShadowMapCache::CullCaster(int index, const AABB& worldBounds)
+{
+    Cascade& cascade = cascades[index];
+    ShadowCullStats& stats = cascade.cullStats;
+    ++stats.tested;
+
+    // 光空间矩阵是正交投影 (仿射变换)，包围盒可以直接整体变换到 NDC
+    AABB ndc = TransformAABB(worldBounds, cascade.lightSpaceMatrix);
+
+    // 与级联的正交盒 ([-1, 1]^3) 向太阳一侧无限延伸后的范围不相交：太阳与接收者之间都没有它
+    // (比近平面更靠近太阳的物体在绘制时用 GL_DEPTH_CLAMP 压到近平面上，仍然会投下阴影，所以不剔除)
+    if (ndc.max.x < -1.0f || ndc.min.x > 1.0f || ndc.max.y < -1.0f || ndc.min.y > 1.0f || ndc.min.z > 1.0f)
+    {
+        ++stats.outside;
+        return true;
+    }
+
+    // 投影尺寸 (纹素)：NDC 的 2 个单位对应 resolution 个纹素
+    glm::vec3 ndcSize = ndc.max - ndc.min;
+    float texels = std::max(ndcSize.x, ndcSize.y) * 0.5f * (float)resolution;
+    if (texels < MIN_CASTER_TEXELS)
+    {
+        ++stats.tooSmall;
+        return true;
+    }
+
+    ++stats.drawn;
+    return false;
+}
+
+const ShadowCullStats& ShadowMapCache::GetCullStats(int index) const
+{
+    return cascades[index].cullStats;
+}
+
+int ShadowMapCache::GetCascadeCount() const
+{
+    return cascadeCount;
+}
+
+int ShadowMapCache::GetResolution() const
+{
+    return resolution;
+}
+
+const glm::mat4& ShadowMapCache::GetLightSpaceMatrix(int cascade) const
+{
+    return cascades[cascade].lightSpaceMatrix;
+}
+
+float ShadowMapCache::GetSplitDistance(int cascade) const
+{
+    return splits[cascade];
+}
+
+float ShadowMapCache::GetTexelWorldSize(int cascade) const
+{
+    return 2.0f * cascades[cascade].halfExtent / (float)resolution;
+}
+
+float ShadowMapCache::GetDepthRange(int cascade) const
+{
+    return cascades[cascade].depthRange;
+}
+
+GLuint ShadowMapCache::GetFramebuffer(int cascade) const
+{
+    return cascades[cascade].fbo;
+}
+
+GLuint ShadowMapCache::GetDepthTexture() const
+{
+    return depthTexture;
+}
+
+unsigned int ShadowMapCache::GetRebuildCount() const
+{
+    return rebuildCount;
+}
@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "../Core/Collision.h"
+
+/*
+ShadowMapCache: 级联阴影图 (CSM) + 跨帧缓存
+
+把相机视锥在 [近平面, shadowDistance] 之间按对数/均匀混合的方式切成 cascadeCount 段，每段用一张
+resolution × resolution 的正交阴影图覆盖 (同一个 GL_TEXTURE_2D_ARRAY 的不同层)，basic.frag 按片段的
+视空间深度选择级联。近处的级联只覆盖几米到十几米，同样的分辨率下阴影比一张覆盖整个场景的大图清晰得多。
+
+    - 每个级联用切片的外接球拟合：球的半径只与 fov/宽高比/切分距离有关，相机旋转时阴影图尺寸不变
+    - 光空间的中心按纹素大小对齐 (texel snapping)，级联跟随相机重建时阴影边缘不会闪烁
+    - 缓存：级联拟合时留出 CACHE_MARGIN 的余量，只要当前切片的外接球仍在已绘制的范围内，
+      且太阳方向 (夹角阈值) 与投射物 (casterHash) 都没变，这一级就不重画。
+      Update 返回本帧需要重画的级联 (位掩码)，调用方只为这些级联声明 Shadow Pass
+    - 没有重建的级联继续使用缓存中的矩阵 (GetLightSpaceMatrix)，与阴影图内容保持一致
+    - 投射物剔除 (CullCaster)：级联的正交盒就是视锥切片 (含余量) 向太阳方向延伸后的范围，
+      包围盒与它不相交的物体不可能给这一级的接收者投下阴影；投影到阴影图上不足 MIN_CASTER_TEXELS
+      个纹素的物体投下的阴影也看不出来，两种都跳过。注意剔除必须针对整个级联而不是当前视锥，
+      缓存的阴影图在相机移动到余量范围内时还要继续使用
+*/
+
+// 阴影投射物剔除统计 (每次重建该级联时清零)
+struct ShadowCullStats
+{
+    unsigned int tested = 0;    // 参与测试的物体数
+    unsigned int drawn = 0;     // 实际绘制的物体数
+    unsigned int outside = 0;   // 不在级联范围内
+    unsigned int tooSmall = 0;  // 投影尺寸低于阈值
+};
+class ShadowMapCache
+{
+public:
+    static constexpr int MAX_CASCADES = 4;
+
+    // resolution: 每个级联的边长；cascadeCount: 2 ~ 4
+    ShadowMapCache(int resolution, int cascadeCount = 3, float angleThresholdDegrees = 0.1f);
+
+    // 创建深度纹理数组与每层的 FBO (需要 GL 上下文)
+    void Init();
+
+    // 阴影覆盖的最远距离 (视空间深度) 与切分方式 (0: 均匀, 1: 对数)
+    void SetShadowDistance(float distance);
+    void SetSplitLambda(float lambda);
+    // 太阳方向变化超过多少度才重建
+    void SetAngleThreshold(float degrees);
+    // 强制下一次 Update 重建所有级联
+    void Invalidate();
+
+    // view/fovY(弧度)/aspect/nearPlane: 主相机; lightDirection: 指向太阳的方向 (SunSystem::direction);
+    // casterHash: 所有投射物变换的哈希。返回本帧需要重画的级联 (第 i 位为 1 表示第 i 级)
+    unsigned int Update(const glm::mat4& view, float fovY, float aspect, float nearPlane,
+        const glm::vec3& lightDirection, size_t casterHash);
+
+    int GetCascadeCount() const;
+    int GetResolution() const;
+    // 第 i 级使用的 光空间 投影 * 视图 矩阵
+    const glm::mat4& GetLightSpaceMatrix(int cascade) const;
+    // 第 i 级覆盖到的视空间深度 (片段深度小于它就用这一级)
+    float GetSplitDistance(int cascade) const;
+    // 第 i 级一个纹素对应的世界尺寸、光空间深度范围 (着色器里换算阴影偏移用)
+    float GetTexelWorldSize(int cascade) const;
+    float GetDepthRange(int cascade) const;
+
+    GLuint GetFramebuffer(int cascade) const;
+    GLuint GetDepthTexture() const;     // GL_TEXTURE_2D_ARRAY
+    // 累计重建的级联次数 (调试用)
+    unsigned int GetRebuildCount() const;
+
+    // 返回 true 表示该物体不需要画进第 cascade 级 (同时记入统计)
+    bool CullCaster(int cascade, const AABB& worldBounds);
+    // 第 cascade 级最近一次重建时的剔除统计
+    const ShadowCullStats& GetCullStats(int cascade) const;
+
+private:
+    struct Cascade
+    {
+        GLuint fbo = 0;
+        bool valid = false;             // 阴影图里是否已经有内容
+        glm::vec3 center = glm::vec3(0.0f);     // 对齐后的中心 (世界空间)
+        float halfExtent = 0.0f;        // 正交投影的半边长 (含余量)
+        float depthRange = 1.0f;
+        glm::vec3 direction = glm::vec3(0.0f);
+        size_t casterHash = 0;
+        glm::mat4 lightSpaceMatrix = glm::mat4(1.0f);
+        ShadowCullStats cullStats;
+    };
+
+    void FitCascade(Cascade& cascade, const glm::vec3& center, float radius, const glm::vec3& direction) const;
+
+    int resolution;
+    int cascadeCount;
+    float shadowDistance = 120.0f;
+    float splitLambda = 0.75f;
+    float cosThreshold;
+
+    GLuint depthTexture = 0;
+    Cascade cascades[MAX_CASCADES];
+    float splits[MAX_CASCADES] = { 0.0f };
+    unsigned int rebuildCount = 0;
+};
@@ -1,4 +1,6 @@
 ﻿#include "Skybox.h"
+#include "TextureManager.h"
+#include "../Core/MappedFile.h"
 
 Skybox::Skybox(std::vector<std::string> faces)
 {
@@ -66,9 +68,11 @@ Skybox::Skybox(std::vector<std::string> faces)
     // 5. 设置 Shader 的纹理单元 (skybox 对应 unit 0)
     skyboxShader->use();
     skyboxShader->setInt("skybox", 0);
+    brightnessUniform = skyboxShader->getUniform<float>("brightness");
+    FrameUniforms::BindBlocks(skyboxShader->ID);
 }
 
-void Skybox::Draw(const glm::mat4& view, const glm::mat4& projection, float brightness)
+void Skybox::Draw(float brightness)
 {
     // 改变深度测试函数，让天空盒在最后绘制 (Optimization)
     glDepthFunc(GL_LEQUAL);
@@ -76,14 +80,9 @@ void Skybox::Draw(const glm::mat4& view, const glm::mat4& projection, float brig
 
     skyboxShader->use();
 
-    // 移除 view 矩阵的位移部分 (只保留旋转)
-    glm::mat4 viewNoTrans = glm::mat4(glm::mat3(view));
-
-    skyboxShader->setMat4("view", viewNoTrans);
-    skyboxShader->setMat4("projection", projection);
-
+    // view 矩阵的位移部分在 skybox.vert 里去掉 (只保留旋转)
     // 传递亮度给 Shader
-    skyboxShader->setFloat("brightness", brightness);
+    skyboxShader->set(brightnessUniform, brightness);
 
     glBindVertexArray(skyboxVAO);
     glActiveTexture(GL_TEXTURE0);
@@ -100,20 +99,38 @@ void Skybox::Draw(const glm::mat4& view, const glm::mat4& projection, float brig
 
 unsigned int Skybox::loadCubemap(std::vector<std::string> faces)
 {
-    unsigned int textureID;
+    // 全局纹理缓存：六个面的路径 (或内容) 都相同的天空盒只上传一次
+    TextureManager& textures = TextureManager::Get();
+    TextureManager::Key key = TextureManager::MakeKey(TextureManager::Kind::Cubemap, faces);
+    unsigned int textureID = textures.Acquire(key);
+    if (textureID) return textureID;
+
+    std::vector<MappedFile> files(faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++)
+    {
+        if (files[i].Open(faces[i]))
+            TextureManager::HashContent(key, files[i].GetData(), files[i].GetSize());
+    }
+    textureID = textures.Acquire(key);
+    if (textureID) return textureID;
+
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
+    size_t bytes = 0;
     for (unsigned int i = 0; i < faces.size(); i++)
     {
         // 这里的路径需要注意，确保 faces 里的路径是正确的
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+        unsigned char* data = files[i].IsOpen()
+            ? stbi_load_from_memory(files[i].GetData(), (int)files[i].GetSize(), &width, &height, &nrChannels, 0)
+            : nullptr;
         if (data)
         {
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
             );
+            bytes += TextureManager::EstimateBytes(width, height, 3, false);
             stbi_image_free(data);
         }
         else
@@ -130,5 +147,5 @@ unsigned int Skybox::loadCubemap(std::vector<std::string> faces)
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-    return textureID;
+    return textures.Add(key, textureID, bytes);
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include "../Core/Shader.h"
+#include "FrameUniforms.h"
 #include "stb_image.h"
 
 class Skybox
@@ -14,13 +15,14 @@ public:
     // 构造函数：传入包含6张图片路径的 vector
     Skybox(std::vector<std::string> faces);
 
-    // 绘制函数
-    void Draw(const glm::mat4& view, const glm::mat4& projection, float brightness = 1.0f);
+    // 绘制函数 (投影/视图矩阵取自共享的 Camera 块，需要 FrameUniforms 已经 Upload)
+    void Draw(float brightness = 1.0f);
 
 private:
     unsigned int skyboxVAO, skyboxVBO;
     unsigned int textureID;
     Shader* skyboxShader; // 天空盒专用的 Shader
+    Uniform<float> brightnessUniform;
 
     // 加载 CubeMap 的辅助函数
     unsigned int loadCubemap(std::vector<std::string> faces);
@@ -0,0 +1,203 @@
+﻿#include "TextureManager.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char* KindName(TextureManager::Kind kind)
+{
+    switch (kind)
+    {
+    case TextureManager::Kind::Material: return "material";
+    case TextureManager::Kind::Sprite: return "sprite";
+    case TextureManager::Kind::Cubemap: return "cubemap";
+    }
+    return "?";
+}
+
+// 文件不存在时 weakly_canonical 也能处理，出错时退回到字面上的规范化
+static std::string CanonicalPath(const std::string& path)
+{
+    std::error_code error;
+    fs::path canonical = fs::weakly_canonical(fs::path(path), error);
+    if (error)
+        canonical = fs::path(path).lexically_normal();
+    return canonical.generic_string();
+}
+
+TextureManager& TextureManager::Get()
+{
+    static TextureManager manager;
+    return manager;
+}
+
+TextureManager::Key TextureManager::MakeKey(Kind kind, const std::string& path)
+{
+    Key key;
+    key.kind = kind;
+    key.path = CanonicalPath(path);
+    return key;
+}
+
+TextureManager::Key TextureManager::MakeKey(Kind kind, const std::vector<std::string>& paths)
+{
+    Key key;
+    key.kind = kind;
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (i > 0) key.path += '|';
+        key.path += CanonicalPath(paths[i]);
+    }
+    return key;
+}
+
+void TextureManager::HashContent(Key& key, const unsigned char* bytes, size_t size)
+{
+    // 第一个文件从 FNV 的初始值开始，之后的文件接着累加
+    uint64_t hash = key.contentSize == 0 ? 14695981039346656037ull : key.contentHash;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    key.contentHash = hash;
+    key.contentSize += size;
+}
+
+size_t TextureManager::EstimateBytes(int width, int height, int components, bool mipmaps)
+{
+    size_t bytes = (size_t)width * height * components;
+    return mipmaps ? bytes + bytes / 3 : bytes;
+}
+
+std::string TextureManager::PathLookup(const Key& key)
+{
+    return std::string(KindName(key.kind)) + ":path:" + key.path;
+}
+
+std::string TextureManager::ContentLookup(const Key& key)
+{
+    return std::string(KindName(key.kind)) + ":content:" + std::to_string(key.contentHash) + ":" + std::to_string(key.contentSize);
+}
+
+bool TextureManager::Contains(const Key& key) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (lookup.count(PathLookup(key))) return true;
+    return key.contentSize != 0 && lookup.count(ContentLookup(key));
+}
+
+GLuint TextureManager::FindLocked(const Key& key)
+{
+    std::string pathLookup = PathLookup(key);
+    auto found = lookup.find(pathLookup);
+    if (found != lookup.end()) return found->second;
+    if (key.contentSize == 0) return 0;
+
+    found = lookup.find(ContentLookup(key));
+    if (found == lookup.end()) return 0;
+    // 相同内容的另一个文件名：记下这个路径，下次不用再读文件
+    GLuint texture = found->second;
+    lookup[pathLookup] = texture;
+    entries[texture].lookups.push_back(pathLookup);
+    return texture;
+}
+
+GLuint TextureManager::Acquire(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    GLuint texture = FindLocked(key);
+    if (texture != 0)
+        ++entries[texture].references;
+    return texture;
+}
+
+GLuint TextureManager::Add(const Key& key, GLuint texture, size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // 两个模型同时加载同一张图时，后上传的那份丢掉
+    GLuint existing = FindLocked(key);
+    if (existing != 0)
+    {
+        if (texture != existing)
+            glDeleteTextures(1, &texture);
+        ++entries[existing].references;
+        return existing;
+    }
+
+    Entry& entry = entries[texture];
+    entry.kind = key.kind;
+    entry.path = key.path;
+    entry.references = 1;
+    entry.bytes = bytes;
+    entry.lookups.push_back(PathLookup(key));
+    if (key.contentSize != 0)
+        entry.lookups.push_back(ContentLookup(key));
+    for (const auto& name : entry.lookups)
+        lookup[name] = texture;
+    return texture;
+}
+
+void TextureManager::Release(GLuint texture)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(texture);
+    if (found == entries.end()) return;
+    if (--found->second.references > 0) return;
+
+    for (const auto& name : found->second.lookups)
+        lookup.erase(name);
+    entries.erase(found);
+    glDeleteTextures(1, &texture);
+}
+
+void TextureManager::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : entries)
+        glDeleteTextures(1, &entry.first);
+    entries.clear();
+    lookup.clear();
+}
+
+size_t TextureManager::GetTextureCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t TextureManager::GetTotalBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t total = 0;
+    for (const auto& entry : entries)
+        total += entry.second.bytes;
+    return total;
+}
+
+void TextureManager::PrintReport() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::pair<GLuint, const Entry*>> sorted;
+    size_t total = 0;
+    for (const auto& entry : entries)
+    {
+        sorted.push_back({ entry.first, &entry.second });
+        total += entry.second.bytes;
+    }
+    // 按占用从大到小
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second->bytes > b.second->bytes; });
+
+    std::cout << "Textures: " << sorted.size() << ", " << std::fixed << std::setprecision(1)
+        << total / (1024.0 * 1024.0) << " MB" << std::endl;
+    for (const auto& item : sorted)
+    {
+        std::cout << "  " << std::setw(8) << item.second->bytes / 1024.0 << " KB  refs " << item.second->references
+            << "  " << KindName(item.second->kind) << "  " << item.second->path << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
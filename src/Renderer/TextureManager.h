@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+TextureManager: 全局的纹理缓存 (所有模型、天空盒、粒子共用)
+
+每张纹理有两个键，任意一个命中就直接复用已经上传的纹理：
+    - 规范化后的路径：同一个文件不管写成相对路径还是带 "../" 都只加载一次
+    - 文件内容的哈希 (FNV-1a 64 + 文件大小)：不同名字的相同文件也只加载一次
+路径命中不需要读文件；路径没命中时调用方读入文件、算出哈希再查一次，还没命中才解码上传，
+上传后用 Add 登记 (按内容命中时把新路径也记下来，下次直接按路径命中)。
+
+纹理按 id 计引用：Acquire / Add 各算一次引用，Release 减一次，减到 0 时删除纹理。
+同一个文件按不同方式上传 (材质贴图、粒子贴图、立方体贴图的参数不同) 是不同的纹理，Kind 是键的一部分。
+查找可以在任意线程 (工作线程用 Contains 跳过已有纹理的解码)；Add / Release / Clear 调用 GL，只能在主线程。
+*/
+class TextureManager
+{
+public:
+    enum class Kind
+    {
+        Material,   // 模型材质贴图 (AssetLoader::UploadTexture)
+        Sprite,     // 粒子贴图 (上下翻转、RGBA、边缘截取)
+        Cubemap     // 天空盒 (多个文件合成一张)
+    };
+
+    struct Key
+    {
+        Kind kind = Kind::Material;
+        std::string path;           // 规范化的路径 (立方体贴图是各个面的路径用 '|' 连接)
+        uint64_t contentHash = 0;
+        uint64_t contentSize = 0;   // 0 表示还没有读文件，只按路径查找
+    };
+
+    static TextureManager& Get();
+
+    // 只含路径的键 (不读文件)
+    static Key MakeKey(Kind kind, const std::string& path);
+    static Key MakeKey(Kind kind, const std::vector<std::string>& paths);
+    // 把文件内容累加进键的哈希 (多个文件依次调用)
+    static void HashContent(Key& key, const unsigned char* bytes, size_t size);
+    // 纹理占用的显存 (估算，mipmap 多算 1/3)
+    static size_t EstimateBytes(int width, int height, int components, bool mipmaps);
+
+    // 是否已经有这张纹理 (不增加引用)
+    bool Contains(const Key& key) const;
+    // 已经有这张纹理时增加引用并返回 id，否则返回 0
+    GLuint Acquire(const Key& key);
+    // 登记刚上传的纹理 (引用数 1)。同一张纹理在此期间已经被别人登记时删除 texture，返回已有的 id
+    GLuint Add(const Key& key, GLuint texture, size_t bytes);
+    // 减少一次引用，没有引用时删除纹理
+    void Release(GLuint texture);
+    // 删除所有纹理 (OpenGL 上下文销毁之前调用)
+    void Clear();
+
+    size_t GetTextureCount() const;
+    size_t GetTotalBytes() const;
+    // 打印每张纹理的大小、引用数和路径
+    void PrintReport() const;
+
+private:
+    struct Entry
+    {
+        Kind kind;
+        std::string path;                   // 第一次加载时的路径 (报告用)
+        int references = 0;
+        size_t bytes = 0;
+        std::vector<std::string> lookups;   // 指向这张纹理的所有查找键
+    };
+
+    static std::string PathLookup(const Key& key);
+    static std::string ContentLookup(const Key& key);
+    // 调用方持有锁：按路径、再按内容查找，按内容命中时补上路径键
+    GLuint FindLocked(const Key& key);
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, GLuint> lookup;
+    std::unordered_map<GLuint, Entry> entries;
+};
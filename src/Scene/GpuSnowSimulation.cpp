@@ -0,0 +1,206 @@
+﻿#include "GpuSnowSimulation.h"
+#include "PrecipitationOcclusion.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+unsigned int GpuSnowSimulation::LoadUpdateShader(const char* vertPath) {
+	std::ifstream file(vertPath, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "Failed to open file: " << vertPath << std::endl;
+		return 0;
+	}
+	// 跳过 UTF-8 BOM
+	unsigned char bom[3] = { 0 };
+	file.read(reinterpret_cast<char*>(bom), 3);
+	if (!(bom[0] == 0xEF && bom[1] == 0xBB && bom[2] == 0xBF)) {
+		file.seekg(0);
+	}
+	std::stringstream ss;
+	ss << file.rdbuf();
+	std::string vertCode = ss.str();
+	const char* vSrc = vertCode.c_str();
+
+	int success;
+	char infoLog[512];
+
+	unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vs, 1, &vSrc, nullptr);
+	glCompileShader(vs);
+	glGetShaderiv(vs, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(vs, 512, NULL, infoLog);
+		std::cout << "ERROR::PARTICLE_UPDATE_VERT::COMPILATION_FAILED\n" << infoLog << std::endl;
+		glDeleteShader(vs);
+		return 0;
+	}
+
+	// 只有顶点着色器：输出通过 Transform Feedback 交错写入同一块缓冲
+	unsigned int prog = glCreateProgram();
+	glAttachShader(prog, vs);
+	const char* varyings[] = { "outPosSize", "outVelLife", "outMotion" };
+	glTransformFeedbackVaryings(prog, 3, varyings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(prog);
+	glDeleteShader(vs);
+
+	glGetProgramiv(prog, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(prog, 512, NULL, infoLog);
+		std::cout << "ERROR::PARTICLE_UPDATE_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+		glDeleteProgram(prog);
+		return 0;
+	}
+	return prog;
+}
+
+bool GpuSnowSimulation::Init(const char* updateVertPath, size_t cap, unsigned int quadVBO) {
+	Release();
+
+	program = LoadUpdateShader(updateVertPath);
+	if (program == 0) return false;
+
+	locDeltaTime = glGetUniformLocation(program, "deltaTime");
+	locTime = glGetUniformLocation(program, "time");
+	locGravity = glGetUniformLocation(program, "gravity");
+	locKillHeight = glGetUniformLocation(program, "killHeight");
+	locSwayAmplitude = glGetUniformLocation(program, "swayAmplitude");
+	locSway = glGetUniformLocation(program, "sway");
+	locWind = glGetUniformLocation(program, "wind");
+	locEmitStart = glGetUniformLocation(program, "emitStart");
+	locEmitCount = glGetUniformLocation(program, "emitCount");
+	locActiveCount = glGetUniformLocation(program, "activeCount");
+	locSeed = glGetUniformLocation(program, "seed");
+	locWrap = glGetUniformLocation(program, "wrap");
+	locWrapCenter = glGetUniformLocation(program, "wrapCenter");
+	locWrapHalfExtent = glGetUniformLocation(program, "wrapHalfExtent");
+	locWrapBottom = glGetUniformLocation(program, "wrapBottom");
+	locWrapHeight = glGetUniformLocation(program, "wrapHeight");
+	locOcclusion = glGetUniformLocation(program, "occlusion");
+	locOcclusionRect = glGetUniformLocation(program, "occlusionRect");
+	locOcclusionRange = glGetUniformLocation(program, "occlusionRange");
+	// 更新着色器只采样遮挡高度图，固定使用 0 号纹理单元
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "occlusionMap"), 0);
+
+	capacity = cap;
+	current = 0;
+	emitCursor = 0;
+	frameSeed = 0;
+
+	// 初始状态全为 0：寿命为 0 即"空槽位"，大小为 0 不可见
+	std::vector<GpuParticleState> zeros(capacity);
+	std::memset(zeros.data(), 0, zeros.size() * sizeof(GpuParticleState));
+
+	glGenBuffers(2, stateVBO);
+	glGenVertexArrays(2, updateVAO);
+	glGenVertexArrays(2, renderVAO);
+
+	const GLsizei stride = sizeof(GpuParticleState);
+	for (int i = 0; i < 2; ++i) {
+		glBindBuffer(GL_ARRAY_BUFFER, stateVBO[i]);
+		glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GpuParticleState), zeros.data(), GL_DYNAMIC_COPY);
+
+		// 模拟用 VAO：每个顶点一个粒子
+		glBindVertexArray(updateVAO[i]);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticleState, posSize));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticleState, velLife));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticleState, motion));
+
+		// 渲染用 VAO：四边形顶点 (location 0/2) + 状态缓冲作为实例属性 (location 3/4)
+		glBindVertexArray(renderVAO[i]);
+		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+		glBindBuffer(GL_ARRAY_BUFFER, stateVBO[i]);
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(GpuParticleState, posSize));
+		glVertexAttribDivisor(3, 1);
+		// motion.z 是角度
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(GpuParticleState, motion) + 2 * sizeof(float)));
+		glVertexAttribDivisor(4, 1);
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+void GpuSnowSimulation::Release() {
+	if (program) glDeleteProgram(program);
+	if (stateVBO[0]) glDeleteBuffers(2, stateVBO);
+	if (updateVAO[0]) glDeleteVertexArrays(2, updateVAO);
+	if (renderVAO[0]) glDeleteVertexArrays(2, renderVAO);
+	program = 0;
+	stateVBO[0] = stateVBO[1] = 0;
+	updateVAO[0] = updateVAO[1] = 0;
+	renderVAO[0] = renderVAO[1] = 0;
+	capacity = 0;
+}
+
+void GpuSnowSimulation::Update(const ParticleUpdateParams& params, const glm::vec3& wind, size_t spawnCount, size_t activeCount) {
+	if (!IsReady() || capacity == 0) return;
+
+	// 发射窗口沿 [0, activeCount) 环形前进：只要槽位数 >= 生成速率 × 最长寿命，窗口扫到的槽位必然已经空出来，
+	// 所以生成速率与 CPU 模式一致；否则窗口内仍存活的粒子保留，本次生成被丢弃
+	activeCount = std::min(activeCount, capacity);
+	size_t emitCount = std::min(spawnCount, activeCount);
+	if (emitCursor >= activeCount) emitCursor = 0;
+	size_t emitStart = emitCursor;
+	if (activeCount > 0) emitCursor = (emitCursor + emitCount) % activeCount;
+	frameSeed = frameSeed * 1664525u + 1013904223u;
+
+	glUseProgram(program);
+	glUniform1f(locDeltaTime, params.deltaTime);
+	glUniform1f(locTime, params.time);
+	glUniform1f(locGravity, params.gravity);
+	glUniform1f(locKillHeight, params.killHeight);
+	glUniform2f(locSwayAmplitude, params.swayAmplitudeX, params.swayAmplitudeZ);
+	glUniform1i(locSway, params.sway ? 1 : 0);
+	glUniform3f(locWind, wind.x, wind.y, wind.z);
+	glUniform1i(locEmitStart, (GLint)emitStart);
+	glUniform1i(locEmitCount, (GLint)emitCount);
+	glUniform1i(locActiveCount, (GLint)activeCount);
+	glUniform1ui(locSeed, frameSeed);
+	glUniform1i(locWrap, params.wrap ? 1 : 0);
+	glUniform2f(locWrapCenter, params.wrapCenterX, params.wrapCenterZ);
+	glUniform1f(locWrapHalfExtent, params.wrapHalfExtent);
+	glUniform1f(locWrapBottom, params.wrapBottom);
+	glUniform1f(locWrapHeight, params.wrapHeight);
+	if (params.occlusion) params.occlusion->Apply(locOcclusion, locOcclusionRect, locOcclusionRange, 0);
+	else glUniform1i(locOcclusion, 0);
+
+	// 读 current，写 1 - current，不做光栅化
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(updateVAO[current]);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateVBO[1 - current]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, (GLsizei)capacity);
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	current = 1 - current;
+}
+
+void GpuSnowSimulation::Draw() {
+	if (!IsReady() || capacity == 0) return;
+
+	// 空槽位大小为 0，退化成不可见的点，不需要知道确切的存活数
+	glBindVertexArray(renderVAO[current]);
+	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)capacity);
+	glBindVertexArray(0);
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "ParticleStore.h"
+
+/*
+GpuSnowSimulation: 基于 Transform Feedback 的雪花 GPU 模拟
+
+	- 粒子状态保存在两块乒乓(ping-pong)顶点缓冲中，每个粒子 12 个 float (GpuParticleState)
+	- 每帧用 particle_update.vert 读一块、写另一块 (关闭光栅化)，重力/风/摆动/寿命都在 GPU 上推进
+	- 生成也在 GPU 上完成：CPU 每帧只推进一个"发射窗口"，窗口内的空槽位在着色器里重生
+	- 降雪遮挡在着色器里采样高度图纹理 (ParticleUpdateParams::occlusion)
+	- 渲染直接把当前状态缓冲当作实例缓冲使用 (particle.vert 的 location 3/4)，数据不回读 CPU
+
+因此每帧的 CPU 开销是常数，与雪花数量无关。
+只用到 OpenGL 3.3 Core 的功能，可以在 Mesa 软件渲染 (llvmpipe) 上运行。
+*/
+
+// GPU 上每个粒子的状态布局 (与 particle_update.vert 的输入/输出一致)
+struct GpuParticleState {
+	glm::vec4 posSize;	// xyz = 位置, w = 大小
+	glm::vec4 velLife;	// xyz = 速度, w = 剩余寿命
+	glm::vec4 motion;	// x = 相位, y = 摆动速度, z = 角度, w = 角速度
+};
+
+class GpuSnowSimulation {
+public:
+	// quadVBO: 雪花四边形的顶点缓冲 (pos + tex，与 ParticleSystem 共用)
+	bool Init(const char* updateVertPath, size_t capacity, unsigned int quadVBO);
+	void Release();
+	bool IsReady() const { return program != 0; }
+	size_t GetCapacity() const { return capacity; }
+
+	// 推进一帧模拟，spawnCount 为本帧需要生成的粒子数，
+	// activeCount 为使用的槽位数 (不超过容量，多出的槽位被清空)
+	void Update(const ParticleUpdateParams& params, const glm::vec3& wind, size_t spawnCount, size_t activeCount);
+	// 用当前状态缓冲做一次实例化绘制 (调用前需绑定好渲染用的 shader 与纹理)
+	void Draw();
+
+private:
+	unsigned int LoadUpdateShader(const char* vertPath);
+
+	unsigned int stateVBO[2] = { 0, 0 };
+	unsigned int updateVAO[2] = { 0, 0 };	// 读 stateVBO[i] 做模拟
+	unsigned int renderVAO[2] = { 0, 0 };	// 四边形 + stateVBO[i] 作为实例属性
+	unsigned int program = 0;
+	int current = 0;						// 当前有效状态所在的缓冲
+
+	size_t capacity = 0;
+	size_t emitCursor = 0;					// 发射窗口的起点 (环形)
+	unsigned int frameSeed = 0;
+
+	GLint locDeltaTime = -1;
+	GLint locTime = -1;
+	GLint locGravity = -1;
+	GLint locKillHeight = -1;
+	GLint locSwayAmplitude = -1;
+	GLint locSway = -1;
+	GLint locWind = -1;
+	GLint locEmitStart = -1;
+	GLint locEmitCount = -1;
+	GLint locActiveCount = -1;
+	GLint locSeed = -1;
+	GLint locWrap = -1;
+	GLint locWrapCenter = -1;
+	GLint locWrapHalfExtent = -1;
+	GLint locWrapBottom = -1;
+	GLint locWrapHeight = -1;
+	GLint locOcclusion = -1;
+	GLint locOcclusionRect = -1;
+	GLint locOcclusionRange = -1;
+};
@@ -0,0 +1,331 @@
+﻿#include "ParticleStore.h"
+#include "ParticleSystem.h"
+#include "PrecipitationOcclusion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+// x64 上 SSE2 总是可用；其他平台退回标量实现
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_USE_SSE 1
+#include <emmintrin.h>
+#endif
+
+static const std::align_val_t STORE_ALIGNMENT = std::align_val_t(32);
+//被遮挡的雪花回到环绕体积顶部时的相对高度 (略低于顶部，避免马上又被绕回到底部)
+static const float OCCLUSION_RESPAWN_HEIGHT = 0.999f;
+
+ParticleStore::~ParticleStore() {
+	if (block) ::operator delete[](block, STORE_ALIGNMENT);
+}
+
+void ParticleStore::Allocate(size_t n) {
+	// 容量取整到 SIMD 宽度的倍数，内核一次处理一整组
+	size_t newCapacity = (n + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+	if (block) ::operator delete[](block, STORE_ALIGNMENT);
+	block = static_cast<float*>(::operator new[](newCapacity * STREAM_COUNT * sizeof(float), STORE_ALIGNMENT));
+	std::memset(block, 0, newCapacity * STREAM_COUNT * sizeof(float));
+
+	float** streams[STREAM_COUNT] = {
+		&posX, &posY, &posZ, &velX, &velY, &velZ,
+		&lifetime, &size, &phase, &swaySpeed, &angle, &angularSpeed
+	};
+	for (size_t k = 0; k < STREAM_COUNT; ++k)
+		*streams[k] = block + k * newCapacity;
+
+	count = 0;
+	head = 0;
+	capacity = newCapacity;
+	alive.assign(capacity, 0);
+}
+
+bool ParticleStore::Push(const SnowParticle& p) {
+	if (count >= capacity) return false;
+	// 追加在末尾的是最新的粒子，环形顺序要先转回从 0 开始
+	if (head != 0) Normalize();
+	Write(count++, p);
+	return true;
+}
+
+bool ParticleStore::Recycle(const SnowParticle& p) {
+	if (count == 0) return false;
+	Write(head, p);
+	// 被覆盖的槽位变成最新的粒子，下一个槽位就是最老的
+	head = (head + 1) % count;
+	return true;
+}
+
+void ParticleStore::Write(size_t i, const SnowParticle& p) {
+	posX[i] = p.position.x;
+	posY[i] = p.position.y;
+	posZ[i] = p.position.z;
+	velX[i] = p.velocity.x;
+	velY[i] = p.velocity.y;
+	velZ[i] = p.velocity.z;
+	lifetime[i] = p.lifetime;
+	size[i] = p.size;
+	phase[i] = p.phase;
+	swaySpeed[i] = p.swaySpeed;
+	angle[i] = p.angle;
+	angularSpeed[i] = p.angularSpeed;
+}
+
+void ParticleStore::DropOldest(size_t n) {
+	if (n >= count) { Clear(); return; }
+	if (head != 0) Normalize();
+	MoveRange(0, n, count - n);
+	count -= n;
+}
+
+void ParticleStore::MoveRange(size_t dst, size_t src, size_t n) {
+	if (dst == src || n == 0) return;
+	float* streams[STREAM_COUNT] = {
+		posX, posY, posZ, velX, velY, velZ,
+		lifetime, size, phase, swaySpeed, angle, angularSpeed
+	};
+	for (size_t k = 0; k < STREAM_COUNT; ++k)
+		std::memmove(streams[k] + dst, streams[k] + src, n * sizeof(float));
+}
+
+void ParticleStore::Rotate(size_t n) {
+	if (n == 0 || n >= count) return;
+	float* streams[STREAM_COUNT] = {
+		posX, posY, posZ, velX, velY, velZ,
+		lifetime, size, phase, swaySpeed, angle, angularSpeed
+	};
+	for (size_t k = 0; k < STREAM_COUNT; ++k)
+		std::rotate(streams[k], streams[k] + n, streams[k] + count);
+}
+
+void ParticleStore::Normalize() {
+	Rotate(head);
+	head = 0;
+}
+
+#ifdef PARTICLE_USE_SSE
+// 4 路并行的 sin/cos
+// 先把角度归约到 [-π, π]，再折叠到 [-π/2, π/2] 用 11 阶泰勒多项式计算 (误差 < 1e-7)
+static inline __m128 SinPoly(__m128 x) {
+	const __m128 x2 = _mm_mul_ps(x, x);
+	__m128 p = _mm_set1_ps(-2.5052108e-8f);
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.7557319e-6f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.9841270e-4f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(8.3333333e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.6666667e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f));
+	return _mm_mul_ps(p, x);
+}
+
+static inline void SinCos4(__m128 x, __m128& s, __m128& c) {
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 pi = _mm_set1_ps(3.14159265f);
+	const __m128 halfPi = _mm_set1_ps(1.57079633f);
+
+	// 归约：x -= round(x / 2π) * 2π (2π 拆成高低两部分以减小误差)
+	__m128 q = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.15915494f))));
+	x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(6.28125f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.9353072e-3f)));
+
+	// sin(x) = sign(x) * sin(min(|x|, π - |x|))
+	__m128 sign = _mm_and_ps(x, signMask);
+	__m128 ax = _mm_andnot_ps(signMask, x);
+	__m128 folded = _mm_min_ps(ax, _mm_sub_ps(pi, ax));
+	s = SinPoly(_mm_or_ps(folded, sign));
+
+	// cos(x) = sin(π/2 - |x|)
+	c = SinPoly(_mm_sub_ps(halfPi, ax));
+}
+
+// SSE2 没有 floor 指令：先截断取整，对负数再减 1
+static inline __m128 Floor4(__m128 x) {
+	__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+// 绕回顶部时的下落速度：由相位 (0~2π) 映射到生成时的速度范围 -0.5~-1.0，每片雪花保持固定
+static inline __m128 WrapFallSpeed4(__m128 phase) {
+	return _mm_sub_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(phase, _mm_set1_ps(0.5f / 6.2831f)));
+}
+
+// 把 x 绕回到 [lo, lo + span) 区间
+static inline __m128 Wrap4(__m128 x, __m128 lo, __m128 span, __m128 invSpan) {
+	__m128 d = _mm_sub_ps(x, lo);
+	d = _mm_sub_ps(d, _mm_mul_ps(Floor4(_mm_mul_ps(d, invSpan)), span));
+	return _mm_add_ps(lo, d);
+}
+
+// 4 个粒子所在位置的遮挡表面高度：SSE 算出纹素下标，再逐个取出 (SSE2 没有 gather)
+static inline __m128 SurfaceHeight4(const PrecipitationOcclusion& occ, __m128 px, __m128 pz) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 scale = _mm_set1_ps(occ.GetTexelsPerMeter());
+	const __m128 res = _mm_set1_ps((float)occ.GetResolution());
+	const __m128 maxIndex = _mm_set1_ps((float)(occ.GetResolution() - 1));
+	__m128 fx = _mm_mul_ps(_mm_sub_ps(px, _mm_set1_ps(occ.GetOriginX())), scale);
+	__m128 fz = _mm_mul_ps(_mm_sub_ps(pz, _mm_set1_ps(occ.GetOriginZ())), scale);
+	__m128 inside = _mm_and_ps(
+		_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, res)),
+		_mm_and_ps(_mm_cmpge_ps(fz, zero), _mm_cmplt_ps(fz, res)));
+
+	// 先夹到合法范围再取整 (非负数截断即向下取整)，下标 iz * res + ix 在 float 精度内是精确的
+	fx = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(fx, zero), maxIndex)));
+	fz = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(fz, zero), maxIndex)));
+	alignas(16) int32_t index[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fz, res), fx)));
+
+	const float* heights = occ.GetHeights();
+	__m128 h = _mm_setr_ps(heights[index[0]], heights[index[1]], heights[index[2]], heights[index[3]]);
+	return _mm_or_ps(_mm_and_ps(inside, h), _mm_andnot_ps(inside, _mm_set1_ps(occ.GetBottom())));
+}
+
+void ParticleStore::Integrate(const ParticleUpdateParams& params) {
+	const __m128 dt = _mm_set1_ps(params.deltaTime);
+	const __m128 gdt = _mm_set1_ps(params.gravity * params.deltaTime);
+	const __m128 t = _mm_set1_ps(params.time);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 killY = _mm_set1_ps(params.killHeight);
+	const __m128 ampX = _mm_set1_ps(params.swayAmplitudeX);
+	const __m128 ampZ = _mm_set1_ps(params.swayAmplitudeZ);
+
+	const float span = 2.0f * params.wrapHalfExtent;
+	const __m128 loX = _mm_set1_ps(params.wrapCenterX - params.wrapHalfExtent);
+	const __m128 loZ = _mm_set1_ps(params.wrapCenterZ - params.wrapHalfExtent);
+	const __m128 spanXZ = _mm_set1_ps(span);
+	const __m128 invSpanXZ = _mm_set1_ps(span > 0.0f ? 1.0f / span : 0.0f);
+	const __m128 loY = _mm_set1_ps(params.wrapBottom);
+	const __m128 spanY = _mm_set1_ps(params.wrapHeight);
+	const __m128 invSpanY = _mm_set1_ps(params.wrapHeight > 0.0f ? 1.0f / params.wrapHeight : 0.0f);
+	const __m128 allLive = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	const __m128 respawnY = _mm_add_ps(loY, _mm_mul_ps(spanY, _mm_set1_ps(OCCLUSION_RESPAWN_HEIGHT)));
+
+	// 容量是 SIMD 宽度的整数倍，尾部多算的几个槽位不会被计入 count
+	const size_t end = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	for (size_t i = 0; i < end; i += SIMD_WIDTH) {
+		__m128 life = _mm_sub_ps(_mm_load_ps(lifetime + i), dt);
+		__m128 vy = _mm_add_ps(_mm_load_ps(velY + i), gdt);
+		__m128 px = _mm_add_ps(_mm_load_ps(posX + i), _mm_mul_ps(_mm_load_ps(velX + i), dt));
+		__m128 py = _mm_add_ps(_mm_load_ps(posY + i), _mm_mul_ps(vy, dt));
+		__m128 pz = _mm_add_ps(_mm_load_ps(posZ + i), _mm_mul_ps(_mm_load_ps(velZ + i), dt));
+
+		__m128 live = _mm_and_ps(_mm_cmpgt_ps(life, zero), _mm_cmpgt_ps(py, killY));
+
+		// 死亡粒子马上会被压缩掉，所以摆动与旋转不需要按掩码屏蔽
+		if (params.sway) {
+			__m128 arg = _mm_add_ps(_mm_mul_ps(t, _mm_load_ps(swaySpeed + i)), _mm_load_ps(phase + i));
+			__m128 s, c;
+			SinCos4(arg, s, c);
+			px = _mm_add_ps(px, _mm_mul_ps(s, ampX));
+			pz = _mm_add_ps(pz, _mm_mul_ps(c, ampZ));
+			_mm_store_ps(angle + i, _mm_add_ps(_mm_load_ps(angle + i), _mm_mul_ps(_mm_load_ps(angularSpeed + i), dt)));
+		}
+
+		if (params.wrap) {
+			// 从底部掉出去的雪花回到顶部，并重置下落速度 (否则在重力下越落越快)
+			__m128 below = _mm_cmplt_ps(py, loY);
+			vy = _mm_or_ps(_mm_and_ps(below, WrapFallSpeed4(_mm_load_ps(phase + i))), _mm_andnot_ps(below, vy));
+			px = Wrap4(px, loX, spanXZ, invSpanXZ);
+			py = Wrap4(py, loY, spanY, invSpanY);
+			pz = Wrap4(pz, loZ, spanXZ, invSpanXZ);
+			live = allLive;
+		}
+
+		if (params.occlusion) {
+			// 落到遮挡表面以下：普通模式死亡；环绕体积中回到顶部继续下落，表面比顶部还高 (整列都被挡住) 时死亡
+			__m128 surface = SurfaceHeight4(*params.occlusion, px, pz);
+			__m128 occluded = _mm_cmple_ps(py, surface);
+			__m128 respawn = params.wrap ? _mm_and_ps(occluded, _mm_cmplt_ps(surface, respawnY)) : zero;
+			py = _mm_or_ps(_mm_and_ps(respawn, respawnY), _mm_andnot_ps(respawn, py));
+			vy = _mm_or_ps(_mm_and_ps(respawn, WrapFallSpeed4(_mm_load_ps(phase + i))), _mm_andnot_ps(respawn, vy));
+			live = _mm_andnot_ps(_mm_andnot_ps(respawn, occluded), live);
+		}
+
+		_mm_store_ps(lifetime + i, life);
+		_mm_store_ps(velY + i, vy);
+		_mm_store_ps(posX + i, px);
+		_mm_store_ps(posY + i, py);
+		_mm_store_ps(posZ + i, pz);
+
+		int bits = _mm_movemask_ps(live);
+		alive[i] = bits & 1;
+		alive[i + 1] = (bits >> 1) & 1;
+		alive[i + 2] = (bits >> 2) & 1;
+		alive[i + 3] = (bits >> 3) & 1;
+	}
+}
+#else
+// 把 x 绕回到 [lo, lo + span) 区间
+static inline float WrapScalar(float x, float lo, float span) {
+	if (span <= 0.0f) return x;
+	float d = x - lo;
+	return lo + d - std::floor(d / span) * span;
+}
+
+void ParticleStore::Integrate(const ParticleUpdateParams& params) {
+	const float dt = params.deltaTime;
+	for (size_t i = 0; i < count; ++i) {
+		lifetime[i] -= dt;
+		velY[i] += params.gravity * dt;
+		posX[i] += velX[i] * dt;
+		posY[i] += velY[i] * dt;
+		posZ[i] += velZ[i] * dt;
+		alive[i] = lifetime[i] > 0.0f && posY[i] > params.killHeight;
+
+		if (params.sway) {
+			float arg = params.time * swaySpeed[i] + phase[i];
+			posX[i] += std::sin(arg) * params.swayAmplitudeX;
+			posZ[i] += std::cos(arg) * params.swayAmplitudeZ;
+			angle[i] += angularSpeed[i] * dt;
+		}
+
+		if (params.wrap) {
+			if (posY[i] < params.wrapBottom) velY[i] = -0.5f - phase[i] * (0.5f / 6.2831f);
+			posX[i] = WrapScalar(posX[i], params.wrapCenterX - params.wrapHalfExtent, 2.0f * params.wrapHalfExtent);
+			posY[i] = WrapScalar(posY[i], params.wrapBottom, params.wrapHeight);
+			posZ[i] = WrapScalar(posZ[i], params.wrapCenterZ - params.wrapHalfExtent, 2.0f * params.wrapHalfExtent);
+			alive[i] = 1;
+		}
+
+		if (params.occlusion) {
+			float surface = params.occlusion->HeightAt(posX[i], posZ[i]);
+			if (posY[i] <= surface) {
+				float respawnY = params.wrapBottom + params.wrapHeight * OCCLUSION_RESPAWN_HEIGHT;
+				if (params.wrap && surface < respawnY) {
+					posY[i] = respawnY;
+					velY[i] = -0.5f - phase[i] * (0.5f / 6.2831f);
+				}
+				else {
+					alive[i] = 0;
+				}
+			}
+		}
+	}
+}
+#endif
+
+size_t ParticleStore::Update(const ParticleUpdateParams& params) {
+	if (count == 0) return 0;
+
+	Integrate(params);
+
+	// 批量压缩：找出连续存活的区段，整段搬移 (保持粒子原有顺序)
+	size_t write = 0;
+	size_t read = 0;
+	size_t beforeHead = 0;	// [0, head) 中存活的粒子数 (这些是环形顺序里较新的粒子)
+	while (read < count) {
+		if (!alive[read]) { ++read; continue; }
+		size_t runStart = read;
+		while (read < count && alive[read]) ++read;
+		if (runStart < head) beforeHead += std::min(read, head) - runStart;
+		MoveRange(write, runStart, read - runStart);
+		write += read - runStart;
+	}
+
+	size_t removed = count - write;
+	count = write;
+	// 本帧有过 Recycle：把较新的那段转到后面，恢复"下标越小越老"
+	if (head != 0) Rotate(beforeHead);
+	head = 0;
+	return removed;
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct SnowParticle;
+class PrecipitationOcclusion;
+
+// 每帧更新参数
+struct ParticleUpdateParams {
+	float deltaTime = 0.0f;
+	float gravity = 0.0f;
+	float time = 0.0f;				// 当前时间 (每帧只取一次，所有粒子共用)
+	float killHeight = -1.0f;		// 低于该高度的粒子被移除
+	float swayAmplitudeX = 0.0f;	// 每帧 x 方向摆动幅度
+	float swayAmplitudeZ = 0.0f;	// 每帧 z 方向摆动幅度
+	bool sway = true;				// 是否应用摆动与旋转 (小雪时关闭)
+
+	// 相机环绕体积：开启后粒子不再死亡，越过体积边界就从另一侧绕回来
+	bool wrap = false;
+	float wrapCenterX = 0.0f;		// 体积水平中心 (相机位置)
+	float wrapCenterZ = 0.0f;
+	float wrapHalfExtent = 0.0f;	// 水平半边长
+	float wrapBottom = 0.0f;		// 体积底部高度
+	float wrapHeight = 0.0f;		// 体积高度
+
+	// 降雪遮挡高度图：落到第一个遮挡表面以下的雪花被移除 (环绕体积中回到顶部)，为空时不检查
+	const PrecipitationOcclusion* occlusion = nullptr;
+};
+
+/*
+ParticleStore: 结构体数组(SoA)形式的雪花粒子存储
+
+与 std::vector<SnowParticle> (AoS) 不同，这里每个属性都是一条独立的连续数组：
+	- posX/posY/posZ, velX/velY/velZ: 位置与速度
+	- lifetime, size: 剩余寿命与大小
+	- phase, swaySpeed: 摆动相关
+	- angle, angularSpeed: 旋转相关
+
+所有数组共用一整块 32 字节对齐的内存，容量向上取整到 SIMD 宽度的倍数，
+这样 Update 内核可以一次处理 4 个粒子，且不需要单独处理尾部。
+活跃粒子始终紧密排列在 [0, count) 区间内。
+
+内存只在 Allocate 时分配一次，之后容量固定 (粒子池)：
+	- Push 把新粒子写到 count 处，死亡粒子的槽位在压缩后都位于尾部，所以复用是 O(1) 的
+	- 池满时 Recycle 用新粒子原地覆盖 head 处最老的粒子，head 沿 [0, count) 环形前进，也是 O(1) 的：
+	  [head, count) 比 [0, head) 更老，Update 压缩时顺带把各数组转回从 0 开始 (head 归零)
+	- 压缩是稳定的，head 为 0 时下标越小的粒子越老；DropOldest 只在预算下调时回收多出的粒子，
+	  丢弃最前面的 n 个，剩下的粒子整体前移 (O(count) 的 memmove)
+*/
+struct ParticleStore {
+	static const size_t SIMD_WIDTH = 4;
+	static const size_t STREAM_COUNT = 12;
+
+	float* posX = nullptr;
+	float* posY = nullptr;
+	float* posZ = nullptr;
+	float* velX = nullptr;
+	float* velY = nullptr;
+	float* velZ = nullptr;
+	float* lifetime = nullptr;
+	float* size = nullptr;
+	float* phase = nullptr;
+	float* swaySpeed = nullptr;
+	float* angle = nullptr;
+	float* angularSpeed = nullptr;
+
+	size_t count = 0;
+	size_t capacity = 0;
+
+	ParticleStore() = default;
+	~ParticleStore();
+	ParticleStore(const ParticleStore&) = delete;
+	ParticleStore& operator=(const ParticleStore&) = delete;
+
+	// 分配能容纳 n 个粒子的固定容量 (会清空已有粒子)
+	void Allocate(size_t n);
+	// 在末尾追加一个粒子，池已满时返回 false
+	bool Push(const SnowParticle& p);
+	// 用新粒子覆盖最老的粒子 (O(1))，没有粒子时返回 false
+	bool Recycle(const SnowParticle& p);
+	// 丢弃最老的 n 个粒子 (预算下调时使用；剩下的粒子整体前移，O(count))
+	void DropOldest(size_t n);
+	void Clear() { count = 0; head = 0; }
+	bool Empty() const { return count == 0; }
+
+	// SIMD 更新内核：积分重力、施加摆动、环绕体积边界、遮挡检测、批量压缩死亡粒子
+	// 返回本帧移除的粒子数
+	size_t Update(const ParticleUpdateParams& params);
+
+private:
+	// 积分一帧运动并写入存活标记 (SSE 或标量实现)
+	void Integrate(const ParticleUpdateParams& params);
+	// 把粒子 p 写到第 i 个槽位
+	void Write(size_t i, const SnowParticle& p);
+	// 把 [src, src + n) 的粒子整体搬到 dst 处 (所有属性数组一起搬)
+	void MoveRange(size_t dst, size_t src, size_t n);
+	// 把 [0, count) 循环左移 n 位 (所有属性数组一起转)
+	void Rotate(size_t n);
+	// 把环形顺序转回从 0 开始 (head 归零)
+	void Normalize();
+
+	float* block = nullptr;			// 所有属性数组共用的对齐内存
+	size_t head = 0;				// 最老的粒子所在的槽位 (Recycle 下一次覆盖的位置)
+	std::vector<uint8_t> alive;		// Update 内核写入的存活标记
+};
@@ -1,8 +1,15 @@
 ﻿#include "ParticleSystem.h"
+#include "PrecipitationOcclusion.h"
+#include "../Renderer/FrameUniforms.h"
+#include "../Renderer/TextureManager.h"
+#include "../Core/MappedFile.h"
 #include <glad/glad.h>
 #include <glm/gtc/random.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
 #include <glfw/glfw3.h>
 
 #include <fstream>
@@ -11,6 +18,23 @@
 
 //必要参数：重力加速度，
 static const float GRAVITY = -0.8f;
+//每帧摆动幅度 (x 方向, z 方向)
+static const float SWAY_AMPLITUDE_X = 0.06f;
+static const float SWAY_AMPLITUDE_Z = 0.03f;
+//低于该高度 (地面以下) 的雪花被移除，也是环绕体积的最低高度
+static const float KILL_HEIGHT = -1.0f;
+//旧的世界盒子：雪花在 100m x 100m 的范围内生成，从最高 80m 一直落到地面，平均寿命 13 秒
+//环绕体积按这个盒子稳定时的雪花密度换算粒子数
+static const float LEGACY_VOLUME = 100.0f * 100.0f * (80.0f - KILL_HEIGHT);
+static const float MEAN_LIFETIME = 13.0f;
+//GPU 模拟使用的更新着色器
+static const char* GPU_UPDATE_SHADER = "assets/shaders/particle_update.vert";
+//无状态模式：每个槽位的重生周期 (不小于最长寿命 18 秒，保证雪花落完才重生)
+static const float STATELESS_CYCLE = 18.0f;
+//CPU/GPU 模式的摆动是按帧累加的，无状态模式按这个帧率换算成每秒幅度，保持观感一致
+static const float SWAY_REFERENCE_FPS = 60.0f;
+//遮挡高度图使用的纹理单元 (0 号是雪花纹理)
+static const int OCCLUSION_TEXTURE_UNIT = 1;
 static float quad[] = {
 	//pos				//tex
 	-0.5f, -0.5f, 0.0f, 0.0f, 0.0f,
@@ -67,10 +91,23 @@ unsigned int ParticleSystem::LoadShader(const char* vertPath, const char* fragPa
 }
 
 unsigned int ParticleSystem::LoadTexture(const char* texturePath) {
+	// 全局纹理缓存：同一张贴图 (路径或内容相同) 只上传一次
+	TextureManager& textures = TextureManager::Get();
+	TextureManager::Key key = TextureManager::MakeKey(TextureManager::Kind::Sprite, texturePath);
+	unsigned int cached = textures.Acquire(key);
+	if (cached) return cached;
+
+	MappedFile file;
+	if (file.Open(texturePath)) {
+		TextureManager::HashContent(key, file.GetData(), file.GetSize());
+		cached = textures.Acquire(key);
+		if (cached) return cached;
+	}
+
 	stbi_set_flip_vertically_on_load(true);
 
 	int w, h, channels;		//w:width, h:height
-	unsigned char* data = stbi_load(texturePath, &w, &h, &channels, 4);
+	unsigned char* data = file.IsOpen() ? stbi_load_from_memory(file.GetData(), (int)file.GetSize(), &w, &h, &channels, 4) : nullptr;
 	if (!data) {
 		std::cout << "Failed to load texture: " << texturePath << std::endl;
 		return 0;
@@ -98,7 +135,7 @@ unsigned int ParticleSystem::LoadTexture(const char* texturePath) {
 	stbi_image_free(data);
 	glBindTexture(GL_TEXTURE_2D, 0);
 
-	return texID;
+	return textures.Add(key, texID, TextureManager::EstimateBytes(w, h, 4, true));
 }
 
 
@@ -116,21 +153,36 @@ void ParticleSystem::Init(const char* vertPath, const char* fragPath, const char
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 
+	// 实例缓冲：每个粒子一份 ParticleInstance，属性除数为 1（每个实例前进一次）
+	glGenBuffers(1, &instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	// location 3: xyz = 位置, w = 大小 (position 与 size 在结构体中是连续的)
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, position));
+	glVertexAttribDivisor(3, 1);
+	// location 4: 旋转角度
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, angle));
+	glVertexAttribDivisor(4, 1);
+
 
 	shader = LoadShader(
 		vertPath,
 		fragPath
 	);
 	textureID = LoadTexture(texturePath);
-	locModel = glGetUniformLocation(shader, "model");
-	// also cache view/projection uniforms so Render can use them
-	locView = glGetUniformLocation(shader, "view");
-	locProj = glGetUniformLocation(shader, "projection");
+	CacheUniformLocations();
+
+	// 一次性分配粒子池与实例缓冲
+	AllocatePool();
 
 	// set sampler to texture unit 0
 	glUseProgram(shader);
 	GLint locTex = glGetUniformLocation(shader, "particleTexture");
 	if (locTex != -1) glUniform1i(locTex, 0);
+	GLint locOcclusionMap = glGetUniformLocation(shader, "occlusionMap");
+	if (locOcclusionMap != -1) glUniform1i(locOcclusionMap, OCCLUSION_TEXTURE_UNIT);
 
 	glBindVertexArray(0);
 }
@@ -147,26 +199,280 @@ void ParticleSystem::SetActive(bool a) {
 	active = a;
 }
 
+float ParticleSystem::GetSpawnRate() const {
+	return spawnRate;
+}
+
+const glm::vec3& ParticleSystem::GetWind() const {
+	return wind;
+}
+
+bool ParticleSystem::IsActive() const {
+	return active;
+}
+
 void ParticleSystem::SetTexture(unsigned int texID) {
 	textureID = texID;
 }
 
 void ParticleSystem::SetShader(unsigned int shaderID) {
 	shader = shaderID;
-	locView = glGetUniformLocation(shader, "view");
-	locProj = glGetUniformLocation(shader, "projection");
+	CacheUniformLocations();
+}
+
+void ParticleSystem::CacheUniformLocations() {
 	locModel = glGetUniformLocation(shader, "model");
+	//投影/视图矩阵来自共享的 Camera 块
+	FrameUniforms::BindBlocks(shader);
+	locUseInstancing = glGetUniformLocation(shader, "useInstancing");
+
+	locStateless = glGetUniformLocation(shader, "stateless");
+	locTime = glGetUniformLocation(shader, "time");
+	locCycleLength = glGetUniformLocation(shader, "cycleLength");
+	locGravity = glGetUniformLocation(shader, "gravity");
+	locKillHeight = glGetUniformLocation(shader, "killHeight");
+	locWind = glGetUniformLocation(shader, "wind");
+	locSwayRate = glGetUniformLocation(shader, "swayRate");
+	locSway = glGetUniformLocation(shader, "sway");
+	locWrap = glGetUniformLocation(shader, "wrap");
+	locWrapCenter = glGetUniformLocation(shader, "wrapCenter");
+	locWrapHalfExtent = glGetUniformLocation(shader, "wrapHalfExtent");
+	locWrapBottom = glGetUniformLocation(shader, "wrapBottom");
+	locWrapHeight = glGetUniformLocation(shader, "wrapHeight");
+	locOcclusion = glGetUniformLocation(shader, "occlusion");
+	locOcclusionRect = glGetUniformLocation(shader, "occlusionRect");
+	locOcclusionRange = glGetUniformLocation(shader, "occlusionRange");
+}
+
+void ParticleSystem::SetInstancing(bool enabled) {
+	useInstancing = enabled;
+}
+
+bool ParticleSystem::IsInstancing() const {
+	return useInstancing;
+}
+
+void ParticleSystem::SetMaxParticles(size_t n) {
+	maxParticles = n;
+	if (VAO != 0) AllocatePool();	// 已经 Init 过则立即按新容量重新分配
+	if (gpuSim.IsReady()) gpuSim.Init(GPU_UPDATE_SHADER, maxParticles, VBO);
+	if (statelessVAO != 0) AllocateStateless();
+}
+
+size_t ParticleSystem::GetMaxParticles() const {
+	return maxParticles;
+}
+
+void ParticleSystem::SetPoolFullPolicy(PoolFullPolicy policy) {
+	poolPolicy = policy;
+}
+
+ParticlePoolStats ParticleSystem::GetPoolStats() const {
+	ParticlePoolStats stats;
+	if (simMode == ParticleSimMode::CPU) stats.live = particles.count;
+	else if (simMode == ParticleSimMode::Stateless) stats.live = StatelessCount();	// 绘制的槽位数
+	else stats.live = 0;
+	stats.capacity = maxParticles;
+	stats.droppedSpawns = droppedSpawns;
+	stats.recycled = recycledParticles;
+	return stats;
+}
+
+void ParticleSystem::SetWrapVolume(bool enabled, float radius) {
+	wrapVolume = enabled;
+	wrapRadius = radius;
+}
+
+bool ParticleSystem::IsWrapVolume() const {
+	return wrapVolume;
+}
 
+void ParticleSystem::SetViewerPosition(const glm::vec3& position) {
+	viewerPosition = position;
 }
 
-void ParticleSystem::SpawnParticle() {
+void ParticleSystem::SetBudgetScale(float scale) {
+	budgetScale = std::min(std::max(scale, 0.0f), 1.0f);
+}
+
+float ParticleSystem::GetBudgetScale() const {
+	return budgetScale;
+}
+
+float ParticleSystem::EffectiveSpawnRate() const {
+	return spawnRate * budgetScale;
+}
+
+// 预算内最多使用的槽位数
+size_t ParticleSystem::ParticleBudget() const {
+	return std::min(maxParticles, (size_t)((float)maxParticles * budgetScale));
+}
+
+void ParticleSystem::SetOcclusion(const PrecipitationOcclusion* occ) {
+	occlusion = occ;
+}
+
+// 环绕体积的竖直范围：相机上下各 R/2，但底部不低于地面
+void ParticleSystem::WrapBounds(float& bottom, float& height) const {
+	bottom = std::max(KILL_HEIGHT, viewerPosition.y - 0.5f * wrapRadius);
+	height = viewerPosition.y + 0.5f * wrapRadius - bottom;
+}
+
+// 环绕体积里的目标粒子数：保持旧世界盒子稳定时 (约 生成速率 × 平均寿命 个粒子) 的雪花密度
+size_t ParticleSystem::WrapTargetCount() const {
+	float bottom, height;
+	WrapBounds(bottom, height);
+	float volume = 4.0f * wrapRadius * wrapRadius * height;
+	size_t n = (size_t)(EffectiveSpawnRate() * MEAN_LIFETIME * volume / LEGACY_VOLUME);
+	return std::min(n, ParticleBudget());
+}
+
+ParticleUpdateParams ParticleSystem::MakeUpdateParams(float deltaTime, bool smallSnow) const {
+	ParticleUpdateParams params;
+	params.deltaTime = deltaTime;
+	params.gravity = GRAVITY;
+	params.time = (float)glfwGetTime();		//每帧只取一次时间
+	params.killHeight = KILL_HEIGHT;
+	params.swayAmplitudeX = SWAY_AMPLITUDE_X;
+	params.swayAmplitudeZ = SWAY_AMPLITUDE_Z;
+	params.sway = !smallSnow;
+
+	if (wrapVolume) {
+		params.wrap = true;
+		params.wrapCenterX = viewerPosition.x;
+		params.wrapCenterZ = viewerPosition.z;
+		params.wrapHalfExtent = wrapRadius;
+		WrapBounds(params.wrapBottom, params.wrapHeight);
+	}
+	//高度图第一次绘制完成之前不检查遮挡
+	if (occlusion && occlusion->IsReady()) params.occlusion = occlusion;
+	return params;
+}
+
+void ParticleSystem::SetSimulationMode(ParticleSimMode mode) {
+	if (mode == ParticleSimMode::GPU && !gpuSim.IsReady()) {
+		if (VAO == 0 || !gpuSim.Init(GPU_UPDATE_SHADER, maxParticles, VBO)) {
+			printf("ParticleSystem: GPU simulation unavailable, staying on CPU\n");
+			return;
+		}
+	}
+	if (mode == ParticleSimMode::Stateless && statelessVAO == 0) {
+		if (VAO == 0) {
+			printf("ParticleSystem: call Init before switching to stateless simulation\n");
+			return;
+		}
+		AllocateStateless();
+	}
+	if (mode == ParticleSimMode::Stateless && simMode != ParticleSimMode::Stateless) statelessTime = 0.0f;
+	// 各模式各自保存粒子状态，切换时清空 CPU 粒子池，避免统计数据过时
+	if (mode != simMode && simMode == ParticleSimMode::CPU) particles.Clear();
+	simMode = mode;
+}
+
+ParticleSimMode ParticleSystem::GetSimulationMode() const {
+	return simMode;
+}
+
+// 粒子池的全部内存 (CPU 端 SoA 存储 + 实例暂存区 + GPU 实例缓冲) 都在这里一次性分配
+void ParticleSystem::AllocatePool() {
+	particles.Allocate(maxParticles);
+	instanceData.clear();
+	instanceData.reserve(maxParticles);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, maxParticles * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	poolFullReported = false;
+}
+
+// 无状态模式的静态实例缓冲：只在这里上传一次，之后不再更新
+void ParticleSystem::AllocateStateless() {
+	if (statelessVAO == 0) {
+		glGenVertexArrays(1, &statelessVAO);
+		glGenBuffers(1, &statelessVBO);
+	}
+	statelessCapacity = maxParticles;
+
+	// 生成时间偏移取黄金分割序列：任意前 n 个槽位在周期内都分布得很均匀，
+	// 所以生成速率变化 (绘制的槽位数变化) 时雪花仍然均匀地错开
+	std::vector<glm::vec2> slots(statelessCapacity);
+	for (size_t i = 0; i < statelessCapacity; ++i) {
+		double offset = (double)i * 0.6180339887498949;
+		slots[i] = glm::vec2((float)(offset - std::floor(offset)), (float)i);
+	}
+
+	glBindVertexArray(statelessVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+	glBindBuffer(GL_ARRAY_BUFFER, statelessVBO);
+	glBufferData(GL_ARRAY_BUFFER, slots.size() * sizeof(glm::vec2), slots.data(), GL_STATIC_DRAW);
+	// location 5: x = 生成时间偏移, y = 随机种子
+	glEnableVertexAttribArray(5);
+	glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+	glVertexAttribDivisor(5, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// 每个槽位每个周期生成一次，所以 生成速率 × 周期 个槽位就能维持该速率
+size_t ParticleSystem::StatelessCount() const {
+	// 环绕体积时雪花只在寿命内可见 (平均 MEAN_LIFETIME)，槽位数按比例放大才能维持目标数量
+	size_t n = wrapVolume ? (size_t)(WrapTargetCount() * (STATELESS_CYCLE / MEAN_LIFETIME)) : (size_t)(EffectiveSpawnRate() * STATELESS_CYCLE);
+	return std::min(n, std::min(statelessCapacity, ParticleBudget()));
+}
+
+// 生成 n 个粒子，池满时按 poolPolicy 处理
+void ParticleSystem::SpawnParticles(size_t n) {
+	size_t budget = ParticleBudget();
+	size_t freeSlots = budget - std::min(particles.count, budget);
+	size_t recycle = 0;
+	if (n > freeSlots) {
+		size_t overflow = n - freeSlots;
+		if (poolPolicy == PoolFullPolicy::RecycleOldest) {
+			// 空槽位填满之后，多出来的粒子逐个覆盖最老的粒子
+			recycle = std::min(overflow, particles.count);
+			recycledParticles += recycle;
+		}
+		droppedSpawns += overflow - recycle;
+		n = freeSlots;
+
+		if (!poolFullReported) {
+			printf("ParticleSystem: particle pool full (%zu), %s\n", maxParticles,
+				poolPolicy == PoolFullPolicy::RecycleOldest ? "recycling oldest particles" : "dropping new spawns");
+			poolFullReported = true;
+		}
+	}
+
+	for (size_t i = 0; i < n; ++i) SpawnParticle(false);
+	for (size_t i = 0; i < recycle; ++i) SpawnParticle(true);
+}
+
+void ParticleSystem::SpawnParticle(bool recycleOldest) {
 	SnowParticle p;
-	//下雪范围: x: -50~50, y: 25~60, z: -50~50
-	p.position = glm::vec3(
-		glm::linearRand(-50.0f, 50.0f),
-		glm::linearRand(25.0f, 80.0f),
-		glm::linearRand(-50.0f, 50.0f)
-	);
+	if (wrapVolume) {
+		//环绕体积：在相机周围的盒子里均匀生成
+		float bottom, height;
+		WrapBounds(bottom, height);
+		p.position = glm::vec3(
+			viewerPosition.x + glm::linearRand(-wrapRadius, wrapRadius),
+			bottom + glm::linearRand(0.0f, height),
+			viewerPosition.z + glm::linearRand(-wrapRadius, wrapRadius)
+		);
+	}
+	else {
+		//下雪范围: x: -50~50, y: 25~60, z: -50~50
+		p.position = glm::vec3(
+			glm::linearRand(-50.0f, 50.0f),
+			glm::linearRand(25.0f, 80.0f),
+			glm::linearRand(-50.0f, 50.0f)
+		);
+	}
 	//初始下落速度
 	p.velocity = glm::vec3(
 		wind.x + glm::linearRand(-0.2f, 0.2f),
@@ -183,47 +489,53 @@ void ParticleSystem::SpawnParticle() {
 	p.angularSpeed = glm::linearRand(-1.0f, 1.0f);
 
 
-	particles.push_back(p);
+	if (recycleOldest) particles.Recycle(p);
+	else particles.Push(p);
 }
 
 void ParticleSystem::Update(float deltaTime, bool smallSnow) {
 	if (!active) return;
 
-	spawnAccumulator += deltaTime * spawnRate;	//累加器
+	if (simMode == ParticleSimMode::Stateless) {
+		//没有逐粒子状态，只推进时间
+		statelessTime += deltaTime;
+		statelessSway = !smallSnow;
+		return;
+	}
+
+	spawnAccumulator += deltaTime * EffectiveSpawnRate();	//累加器
 	//按速率精确生成新粒子
-	while (spawnAccumulator >= 1.0f) {
-		SpawnParticle();
-		spawnAccumulator -= 1.0f;
+	size_t toSpawn = (size_t)spawnAccumulator;
+	spawnAccumulator -= (float)toSpawn;
+
+	ParticleUpdateParams params = MakeUpdateParams(deltaTime, smallSnow);
+
+	if (simMode == ParticleSimMode::GPU) {
+		//生成与更新都在 GPU 上完成；环绕体积时只使用前 WrapTargetCount() 个槽位
+		gpuSim.Update(params, wind, toSpawn, wrapVolume ? WrapTargetCount() : ParticleBudget());
+		return;
 	}
 
-	//倒序更新，以便删除粒子
-	for (int i = (int)particles.size() - 1; i >= 0; --i) {
-		auto& p = particles[i];
-		p.lifetime -= deltaTime;
-		p.velocity.y += GRAVITY * deltaTime;
-		p.position += p.velocity * deltaTime;
-
-		if (p.lifetime <= 0.0f || p.position.y <= -1.0f) {
-			std::swap(p, particles.back());
-			particles.pop_back();
-			//particles.erase(particles.begin() + i);
-		}
-		else {
-			if (!smallSnow) {
-				float t = glfwGetTime();
-				p.position.x += sin(t * p.swaySpeed + p.phase) * 0.06f; // 0.06f为摆动幅度
-				p.position.z += cos(t * p.swaySpeed + p.phase) * 0.03f;
-				p.angle += p.angularSpeed * deltaTime;
-			}
-		}
+	//超出目标数 (环绕体积的目标数 / 预算下调后的上限) 时按生成速率回收最老的粒子，不会一下子消失一大片
+	size_t target = wrapVolume ? WrapTargetCount() : ParticleBudget();
+	if (particles.count > target) particles.DropOldest(std::min(particles.count - target, toSpawn));
+	if (wrapVolume) {
+		//环绕体积中粒子不会死亡，数量维持在目标值：不足时按生成速率补充
+		toSpawn = particles.count < target ? std::min(toSpawn, target - particles.count) : 0;
 	}
+
+	//SoA + SIMD 更新：积分重力、摆动，并批量移除死亡粒子
+	SpawnParticles(toSpawn);
+	particles.Update(params);
 }
 
-void ParticleSystem::Render(const glm::mat4& view, const glm::mat4& projection) {
-	if (!active || particles.empty()) return;
+void ParticleSystem::Render(const glm::mat4& view) {
+	if (!active) return;
+	if (simMode == ParticleSimMode::CPU && particles.Empty()) return;
 
 	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// alpha 通道按 "over" 累积覆盖率，画到离屏透明目标时颜色即为预乘 alpha (见 LowResParticlePass)
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	glDepthMask(GL_FALSE);
 
 	if (shader == 0) {
@@ -239,27 +551,94 @@ void ParticleSystem::Render(const glm::mat4& view, const glm::mat4& projection)
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
-	if (locView != -1) glUniformMatrix4fv(locView, 1, GL_FALSE, &view[0][0]);
-	else printf("ParticleSystem::Render: 'view' uniform not found in shader!\n");
+	if (locStateless != -1) glUniform1i(locStateless, simMode == ParticleSimMode::Stateless ? 1 : 0);
 
-	if (locProj != -1) glUniformMatrix4fv(locProj, 1, GL_FALSE, &projection[0][0]);
-	else printf("ParticleSystem::Render: 'projection' uniform not found in shader!\n");
+	if (simMode == ParticleSimMode::Stateless) {
+		RenderStateless();
+	}
+	else if (simMode == ParticleSimMode::GPU) {
+		//直接用 GPU 上的状态缓冲做实例属性
+		if (locUseInstancing != -1) glUniform1i(locUseInstancing, 1);
+		gpuSim.Draw();
+	}
+	else {
+		glBindVertexArray(VAO);
 
+		if (useInstancing) RenderInstanced();
+		else RenderPerParticle(view);
 
-	glBindVertexArray(VAO);
+		glBindVertexArray(0);
+	}
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
+
+// 实例化路径：把所有粒子打包进实例缓冲，一次 DrawCall 画完
+// 看板与旋转在 particle.vert 中完成
+void ParticleSystem::RenderInstanced() {
+	if (locUseInstancing != -1) glUniform1i(locUseInstancing, 1);
+
+	instanceData.resize(particles.count);
+	for (size_t i = 0; i < particles.count; ++i) {
+		instanceData[i].position = glm::vec3(particles.posX[i], particles.posY[i], particles.posZ[i]);
+		instanceData[i].size = particles.size[i];
+		instanceData[i].angle = particles.angle[i];
+	}
 
-	for (const auto& p : particles) {
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	size_t bytes = instanceData.size() * sizeof(ParticleInstance);
+	// 缓冲区孤立(orphaning)：大小不变，让驱动换一块新内存，避免等待上一帧的绘制读完
+	glBufferData(GL_ARRAY_BUFFER, maxParticles * sizeof(ParticleInstance), nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instanceData.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)instanceData.size());
+}
+
+// 无状态路径：只设置几个 uniform，雪花的运动全部在 particle.vert 中按时间计算
+void ParticleSystem::RenderStateless() {
+	size_t n = StatelessCount();
+	if (n == 0) return;
+
+	glUniform1f(locTime, statelessTime);
+	glUniform1f(locCycleLength, STATELESS_CYCLE);
+	glUniform1f(locGravity, GRAVITY);
+	glUniform1f(locKillHeight, KILL_HEIGHT);
+	glUniform3f(locWind, wind.x, wind.y, wind.z);
+	glUniform2f(locSwayRate, SWAY_AMPLITUDE_X * SWAY_REFERENCE_FPS, SWAY_AMPLITUDE_Z * SWAY_REFERENCE_FPS);
+	glUniform1i(locSway, statelessSway ? 1 : 0);
+
+	ParticleUpdateParams params = MakeUpdateParams(0.0f, !statelessSway);
+	glUniform1i(locWrap, params.wrap ? 1 : 0);
+	glUniform2f(locWrapCenter, params.wrapCenterX, params.wrapCenterZ);
+	glUniform1f(locWrapHalfExtent, params.wrapHalfExtent);
+	glUniform1f(locWrapBottom, params.wrapBottom);
+	glUniform1f(locWrapHeight, params.wrapHeight);
+	if (occlusion) occlusion->Apply(locOcclusion, locOcclusionRect, locOcclusionRange, OCCLUSION_TEXTURE_UNIT);
+	else glUniform1i(locOcclusion, 0);
+
+	glBindVertexArray(statelessVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)n);
+	glBindVertexArray(0);
+}
+
+// 旧的逐粒子路径：CPU 构造模型矩阵，每个粒子一次 uniform 上传 + 一次 DrawCall
+void ParticleSystem::RenderPerParticle(const glm::mat4& view) {
+	if (locUseInstancing != -1) glUniform1i(locUseInstancing, 0);
+
+	for (size_t i = 0; i < particles.count; ++i) {
 		//构造模型矩阵
 		glm::mat4 model(1.0f);
-		model = glm::translate(model, p.position);
-		model = glm::rotate(model, p.angle, glm::vec3(0, 0, 1));
+		model = glm::translate(model, glm::vec3(particles.posX[i], particles.posY[i], particles.posZ[i]));
+		model = glm::rotate(model, particles.angle[i], glm::vec3(0, 0, 1));
 
 		//看板逻辑Billboarding
 		model[0][0] = view[0][0]; model[0][1] = view[1][0]; model[0][2] = view[2][0];
 		model[1][0] = view[0][1]; model[1][1] = view[1][1]; model[1][2] = view[2][1];
 		model[2][0] = view[0][2]; model[2][1] = view[1][2]; model[2][2] = view[2][2];
 
-		model = glm::scale(model, glm::vec3(p.size));
+		model = glm::scale(model, glm::vec3(particles.size[i]));
 
 
 		if (locModel != -1) glUniformMatrix4fv(locModel, 1, GL_FALSE, &model[0][0]);
@@ -268,12 +647,4 @@ void ParticleSystem::Render(const glm::mat4& view, const glm::mat4& projection)
 		//四边形绘制
 		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 	}
-
-	glBindVertexArray(0);
-
-	glDepthMask(GL_TRUE);
-	glDisable(GL_BLEND);
 }
-
-
-
@@ -1,11 +1,14 @@
-﻿#include<vector>
+﻿#pragma once
+#include<vector>
 #include<glm/glm.hpp>
 #include<glad/glad.h> 
+#include "ParticleStore.h"
+#include "GpuSnowSimulation.h"
 
 /*
 参数说明：
 
-SnowParticle: 单个雪花粒子的数据结构
+SnowParticle: 单个雪花粒子的数据结构 (仅在生成粒子时使用，生成后拆分写入 ParticleStore 的各属性数组)
 其中：
 	- position: 粒子位置
 	- velocity: 粒子速度
@@ -17,12 +20,46 @@ ParticleSystem: 粒子系统类，管理雪花粒子的生成、更新和渲染
 	- spawnRate: 生成粒子的速率（每秒多少个）
 	- wind: 风的影响向量
 	- active: 粒子系统是否激活
-	- particles: 存储所有活跃粒子的容器
+	- particles: 存储所有活跃粒子的容器 (SoA 布局的 ParticleStore，见 ParticleStore.h)
 	- spawnAccumulator: 用于按速率生成粒子的累加器
 
 要修改SnowParticle的属性范围，请到ParticleSystem.cpp中的ParticleSystem::SpawnParticle()函数中修改粒子生成时的随机范围。
 
 
+粒子池：
+	- 粒子存储在 Init 时按 maxParticles 一次性分配，帧循环中不再有任何内存分配
+	- 池满时的行为由 PoolFullPolicy 决定：丢弃新粒子 / 回收最老的粒子
+	- GetPoolStats() 返回池的占用情况 (活跃数、容量、累计丢弃/回收数)
+
+渲染路径：
+	- 默认使用实例化渲染：每帧把所有粒子的 位置/大小/角度 写入实例缓冲(instanceVBO)，
+	  在 particle.vert 中完成看板(Billboard)构建，整场雪只需一次 glDrawArraysInstanced
+	- SetInstancing(false) 切回旧的逐粒子绘制路径(每个粒子一次 uniform 上传 + 一次 DrawCall)，便于 A/B 对比
+
+模拟模式 (SetSimulationMode)：
+	- CPU: 上面的 SoA 粒子池，每帧在 CPU 上更新后上传实例数据
+	- GPU: Transform Feedback 模拟 (GpuSnowSimulation)，生成/更新/渲染都在 GPU 上，CPU 每帧只设置几个 uniform
+	  GPU 模式下容量同样是 maxParticles，池满时新粒子被丢弃；存活数不回读，GetPoolStats().live 为 0
+	- Stateless: 无状态模式，每个雪花只在静态缓冲里存一份 (生成时间偏移, 随机种子)，只在切换时上传一次；
+	  位置/角度由 particle.vert 按当前时间解析计算 (匀加速 + 摆动的积分)，CPU 每帧没有任何逐粒子工作。
+	  每个槽位以 STATELESS_CYCLE 为周期反复重生，绘制的槽位数 = 生成速率 × 周期 (不超过 maxParticles)
+
+相机环绕体积 (SetWrapVolume，默认开启)：
+	- 雪花只存在于以相机为中心的盒子里：水平半边长 R，竖直方向为相机上下各 R/2 (底部不低于地面)
+	- 雪花不再死亡/重生，越过盒子边界就从对面绕回来；从底部落出的雪花回到顶部并重置下落速度
+	- 雪花在世界空间中不随相机移动，相机走动时盒子在世界里"平铺"，所以感觉不到边界
+	- 粒子数 = 旧的 ±50m 世界盒子里的雪花密度 × 环绕体积，密度不变而粒子数只有原来的一小部分
+	- 三种模拟模式都支持；需要每帧通过 SetViewerPosition 告诉粒子系统相机位置 (SnowScene::Update 中完成)
+
+降雪遮挡 (SetOcclusion)：
+	- 雪花落到遮挡高度图 (PrecipitationOcclusion) 记录的第一个表面 (屋顶、车顶、地面...) 时就不再继续下落，
+	  不会穿过屋顶出现在室内，也不会在地下继续模拟到寿命结束
+	- CPU 模式在 SIMD 内核里查 CPU 端高度图；GPU/无状态模式在顶点着色器里采样高度图纹理
+
+预算系数 (SetBudgetScale，由 FrameGovernor 决定)：
+	- SetSpawnRate 设置的是"想要的"生成速率，实际生效的生成速率与粒子数上限都乘以预算系数
+	- 粒子池容量不变 (不重新分配)，只是最多使用其中 maxParticles × 系数 个槽位
+
 要修改PatrticleSystem初始化的参数，请到Scene.cpp中的SnowScene::Init函数中修改粒子系统的相关设置。
 主要是涉及到：
 		void SetSpawnRate(float rate);
@@ -52,39 +89,159 @@ struct SnowParticle {
 	}
 };
 
+// 粒子池已满时新粒子的处理策略
+enum class PoolFullPolicy {
+	DropSpawns,		// 丢弃本次要生成的粒子 (O(1))
+	RecycleOldest	// 新粒子原地覆盖最老的粒子 (O(1)，见 ParticleStore::Recycle)
+};
+
+// 粒子池占用情况
+struct ParticlePoolStats {
+	size_t live = 0;			// 当前活跃粒子数
+	size_t capacity = 0;		// 池容量 (最大粒子数)
+	size_t droppedSpawns = 0;	// 因池满而被丢弃的生成次数 (累计)
+	size_t recycled = 0;		// 被回收的老粒子数 (累计)
+
+	float Occupancy() const { return capacity > 0 ? (float)live / (float)capacity : 0.0f; }
+};
+
+// 粒子模拟在哪里进行
+enum class ParticleSimMode {
+	CPU,	// SoA 粒子池 + SIMD 更新
+	GPU,		// Transform Feedback，粒子状态常驻显存
+	Stateless	// 无状态，顶点着色器按时间解析计算
+};
+
+// 实例化渲染时每个粒子上传给 GPU 的数据 (与 particle.vert 中 location 3/4 对应)
+struct ParticleInstance {
+	glm::vec3 position;
+	float size;
+	float angle;
+};
+
 class ParticleSystem {
 public:
 	void Init(const char* vertPath, const char* fragPath, const char* texturePath);
 	void Update(float deltaTime, bool smallSnow);
-	void Render(const glm::mat4& view, const glm::mat4& proj);
+	//投影/视图矩阵取自与场景共享的 Camera 块 (FrameUniforms)，view 只用于 CPU 端的看板朝向
+	void Render(const glm::mat4& view);
 
 	void SetSpawnRate(float rate);
 	void SetWind(const glm::vec3& wind);
 	void SetActive(bool active);
+	float GetSpawnRate() const;
+	const glm::vec3& GetWind() const;
+	bool IsActive() const;
 
 	void SetTexture(unsigned int texID);
 	void SetShader(unsigned int shaderID);
 
+	// 实例化渲染开关 (true: 一次 DrawCall 画完所有雪花; false: 旧的逐粒子绘制)
+	void SetInstancing(bool enabled);
+	bool IsInstancing() const;
+
+	// 粒子池配置：最好在 Init 之前调用，Init 之后调用会重新分配 (并清空现有粒子)
+	void SetMaxParticles(size_t maxParticles);
+	size_t GetMaxParticles() const;
+	void SetPoolFullPolicy(PoolFullPolicy policy);
+	ParticlePoolStats GetPoolStats() const;
+
+	// 相机环绕体积：radius 为水平半边长，一般取视距的一部分 (远处的雪花小于一个像素，没有意义)
+	void SetWrapVolume(bool enabled, float radius);
+	bool IsWrapVolume() const;
+	void SetViewerPosition(const glm::vec3& position);
+
+	// 预算系数 (0~1)：缩放实际生效的生成速率与粒子数上限，GetSpawnRate 仍返回设置的速率
+	void SetBudgetScale(float scale);
+	float GetBudgetScale() const;
+
+	// 降雪遮挡高度图 (由调用方持有，为空时不检查遮挡)
+	void SetOcclusion(const PrecipitationOcclusion* occlusion);
+
+	// 模拟模式：GPU/无状态模式在第一次切换时初始化 (需要 GL 上下文，且要在 Init 之后)
+	void SetSimulationMode(ParticleSimMode mode);
+	ParticleSimMode GetSimulationMode() const;
+
 private:
-	void SpawnParticle();
+	void AllocatePool();
+	void AllocateStateless();
+	size_t StatelessCount() const;
+	float EffectiveSpawnRate() const;
+	size_t ParticleBudget() const;
+	void WrapBounds(float& bottom, float& height) const;
+	size_t WrapTargetCount() const;
+	ParticleUpdateParams MakeUpdateParams(float deltaTime, bool smallSnow) const;
+	void SpawnParticles(size_t n);
+	// recycleOldest 为 true 时覆盖最老的粒子，否则追加到池末尾
+	void SpawnParticle(bool recycleOldest);
+	void RenderInstanced();
+	void RenderPerParticle(const glm::mat4& view);
+	void RenderStateless();
+	void CacheUniformLocations();
 	unsigned int LoadShader(const char* vertPath, const char* fragPath);
 	unsigned int LoadTexture(const char* texturePath);
 
 
-	std::vector<SnowParticle> particles;
+	ParticleStore particles;
 	float spawnRate = 10.0f; // particles per second
 	float spawnAccumulator = 0.0f;
 	glm::vec3 wind = glm::vec3(0.2f, 0.0f, 0.1f);
 	bool active = false;
 
+	//粒子池相关
+	size_t maxParticles = 32768;
+	PoolFullPolicy poolPolicy = PoolFullPolicy::RecycleOldest;
+	size_t droppedSpawns = 0;
+	size_t recycledParticles = 0;
+	bool poolFullReported = false;	// 池满只提示一次，避免刷屏
+	float budgetScale = 1.0f;		// 帧时间调节器给出的预算系数
+
 	//渲染相关
 	unsigned int VAO = 0, VBO = 0;
 	unsigned int shader = 0;
 	unsigned int textureID = 0;
 
-	GLint locView = -1;
-	GLint locProj = -1;
+	//实例化渲染相关
+	bool useInstancing = true;
+	unsigned int instanceVBO = 0;				// 容量 = maxParticles，Init 时分配
+	std::vector<ParticleInstance> instanceData;	// 每帧填充后整体上传 (容量同样在 Init 时预留)
+
+	//相机环绕体积相关
+	bool wrapVolume = true;
+	float wrapRadius = 40.0f;
+	glm::vec3 viewerPosition = glm::vec3(0.0f);
+
+	//降雪遮挡
+	const PrecipitationOcclusion* occlusion = nullptr;
+
+	//GPU 模拟相关
+	ParticleSimMode simMode = ParticleSimMode::CPU;
+	GpuSnowSimulation gpuSim;
+
+	//无状态模式相关
+	unsigned int statelessVAO = 0, statelessVBO = 0;	// 四边形 + 每个槽位的 (生成时间偏移, 种子)
+	size_t statelessCapacity = 0;
+	float statelessTime = 0.0f;		// 只在激活时累加，暂停下雪时雪花也跟着停住
+	bool statelessSway = true;
+
 	GLint locModel = -1;
+	GLint locUseInstancing = -1;
+	GLint locStateless = -1;
+	GLint locTime = -1;
+	GLint locCycleLength = -1;
+	GLint locGravity = -1;
+	GLint locKillHeight = -1;
+	GLint locWind = -1;
+	GLint locSwayRate = -1;
+	GLint locSway = -1;
+	GLint locWrap = -1;
+	GLint locWrapCenter = -1;
+	GLint locWrapHalfExtent = -1;
+	GLint locWrapBottom = -1;
+	GLint locWrapHeight = -1;
+	GLint locOcclusion = -1;
+	GLint locOcclusionRect = -1;
+	GLint locOcclusionRange = -1;
 };
 
 
@@ -0,0 +1,83 @@
+﻿#include "PrecipitationOcclusion.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+
+void PrecipitationOcclusion::Init(const glm::vec2& center, float halfExtent, float bottomHeight, float topHeight, int res) {
+	resolution = res;
+	originX = center.x - halfExtent;
+	originZ = center.y - halfExtent;
+	size = 2.0f * halfExtent;
+	texelsPerMeter = (float)resolution / size;
+	bottom = bottomHeight;
+	top = topHeight;
+
+	// 相机在覆盖范围正上方向下看，up 取 -z：屏幕 x 对应世界 x，屏幕 y 对应世界 -z
+	// 正交投影下深度是线性的：height = top - depth * (top - bottom)
+	glm::mat4 view = glm::lookAt(glm::vec3(center.x, top, center.y), glm::vec3(center.x, bottom, center.y), glm::vec3(0.0f, 0.0f, -1.0f));
+	glm::mat4 projection = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, 0.0f, top - bottom);
+	viewProjection = projection * view;
+
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	// 范围以外视为没有遮挡 (深度 1 = bottom)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::PRECIPITATION_OCCLUSION:: Framebuffer is not complete!" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	heights.assign((size_t)resolution * resolution, bottom);
+	dirty = true;
+	ready = false;
+}
+
+void PrecipitationOcclusion::Begin() {
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &savedFBO);
+	glGetIntegerv(GL_VIEWPORT, savedViewport);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glViewport(0, 0, resolution, resolution);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void PrecipitationOcclusion::End() {
+	// 读回深度并换算成高度；纹理第 0 行对应 z 最大处，翻转后 heights 的行从 originZ 开始
+	std::vector<float> depth((size_t)resolution * resolution);
+	glReadPixels(0, 0, resolution, resolution, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+	for (int row = 0; row < resolution; ++row) {
+		const float* src = &depth[(size_t)row * resolution];
+		float* dst = &heights[(size_t)(resolution - 1 - row) * resolution];
+		for (int col = 0; col < resolution; ++col)
+			dst[col] = top - src[col] * (top - bottom);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, savedFBO);
+	glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+	dirty = false;
+	ready = true;
+}
+
+void PrecipitationOcclusion::Apply(GLint locEnabled, GLint locRect, GLint locRange, int unit) const {
+	glUniform1i(locEnabled, ready ? 1 : 0);
+	if (!ready) return;
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+	// x, z 方向的起点与 1 / 边长
+	glUniform3f(locRect, originX, originZ, 1.0f / size);
+	glUniform2f(locRange, bottom, top);
+}
@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/*
+PrecipitationOcclusion: 降雪遮挡高度图
+
+从正上方用正交投影把场景几何体画成一张深度图 (与阴影贴图的深度 Pass 相同，复用 shadow_depth 着色器)，
+每个纹素记录该 (x, z) 处雪花落下时遇到的第一个表面的高度 (屋顶、车顶、树冠、地面...)。
+	- 只在场景变化时重新绘制：IsDirty() 为 true 时调用方用 GetViewProjection() 画一遍场景，包在 Begin/End 之间；
+	  物体移动/增删后调用 MarkDirty()
+	- End 时把深度读回 CPU 并换算成高度 (heights)，供 ParticleStore 的 SIMD 内核查询
+	- GPU/无状态模式直接在顶点着色器里采样同一张深度纹理 (Apply 设置纹理与 uniform)
+
+雪花落到表面以下时：普通模式下直接死亡；环绕体积中回到体积顶部 (表面高于体积顶部时死亡)。
+高度图覆盖范围以外、以及没有几何体的地方高度为 bottom。
+*/
+class PrecipitationOcclusion {
+public:
+	// center/halfExtent: 覆盖的水平范围; bottom/top: 高度范围; resolution: 高度图边长 (纹素)
+	void Init(const glm::vec2& center, float halfExtent, float bottom, float top, int resolution);
+	bool IsReady() const { return ready; }
+
+	// 场景变化后调用，下一帧重新绘制
+	void MarkDirty() { dirty = true; }
+	bool IsDirty() const { return dirty && fbo != 0; }
+
+	// 绘制场景时使用的 投影 * 视图 矩阵 (传给 shadow_depth 着色器的 lightSpaceMatrix)
+	const glm::mat4& GetViewProjection() const { return viewProjection; }
+	// 绑定高度图 FBO 并清空深度; End 读回高度并恢复之前的帧缓冲与视口
+	void Begin();
+	void End();
+
+	// 该位置第一个遮挡表面的高度
+	float HeightAt(float x, float z) const {
+		int ix = (int)((x - originX) * texelsPerMeter);
+		int iz = (int)((z - originZ) * texelsPerMeter);
+		if (x < originX || z < originZ || ix >= resolution || iz >= resolution) return bottom;
+		return heights[iz * resolution + ix];
+	}
+
+	// 给 SIMD 内核直接访问的数据：heights[iz * resolution + ix]，iz/ix 从 (originX, originZ) 开始
+	const float* GetHeights() const { return heights.data(); }
+	int GetResolution() const { return resolution; }
+	float GetOriginX() const { return originX; }
+	float GetOriginZ() const { return originZ; }
+	float GetTexelsPerMeter() const { return texelsPerMeter; }
+	float GetBottom() const { return bottom; }
+
+	// 把高度图绑定到 unit 号纹理单元，并设置着色器中的 occlusion / occlusionRect / occlusionRange
+	// (采样器 occlusionMap 需要事先指向同一个纹理单元)；高度图还没准备好时只把 occlusion 设为 false
+	void Apply(GLint locEnabled, GLint locRect, GLint locRange, int unit) const;
+
+private:
+	unsigned int fbo = 0, depthTexture = 0;
+	int resolution = 0;
+	float originX = 0.0f, originZ = 0.0f;	// 覆盖范围的最小 x/z
+	float size = 0.0f;						// 覆盖范围的边长
+	float texelsPerMeter = 0.0f;
+	float bottom = 0.0f, top = 0.0f;
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+
+	std::vector<float> heights;		// CPU 端高度图
+	bool dirty = true;
+	bool ready = false;
+
+	GLint savedFBO = 0;
+	GLint savedViewport[4] = { 0, 0, 0, 0 };
+};
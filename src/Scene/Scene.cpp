@@ -1,6 +1,22 @@
 ﻿#include "Scene.h"
 #include "Core/Camera.h"
 
+//雪景的视距 (投影远平面)
+static const float SNOW_VIEW_DISTANCE = 100.0f;
+//相机环绕体积的水平半边长占视距的比例：更远处的雪花已经小于一个像素
+static const float WRAP_RADIUS_RATIO = 0.4f;
+//降雪 LOD 开启时真实粒子的范围 (米)，更远处交给雪层
+static const float LOD_NEAR_RADIUS = 16.0f;
+//预算系数降到最低时，真实粒子的范围缩小到原来的这个比例
+static const float MIN_RANGE_RATIO = 0.5f;
+//降雪遮挡高度图：覆盖以原点为中心 128m x 128m 的村庄，高度从地面以下 (与粒子的 KILL_HEIGHT 一致) 到 60m
+//1024 x 1024 的分辨率下每个纹素 0.125m
+static const glm::vec2 OCCLUSION_CENTER = glm::vec2(0.0f, 0.0f);
+static const float OCCLUSION_HALF_EXTENT = 64.0f;
+static const float OCCLUSION_BOTTOM = -1.0f;
+static const float OCCLUSION_TOP = 60.0f;
+static const int OCCLUSION_RESOLUTION = 1024;
+
 void SnowScene::Init(const char* vertPath, const char* fragPath, const char* texturePath) {
 	//Camera::Camera(glm::vec3 position, glm::vec3 up, float yaw, float pitch)
 	//camera = Camera(glm::vec3(0.0f, 3.0f, 6.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, 0.0f);
@@ -9,13 +25,52 @@ void SnowScene::Init(const char* vertPath, const char* fragPath, const char* tex
 	particleSystem.SetActive(false);
 	particleSystem.SetSpawnRate(1000.0f);
 	particleSystem.SetWind(glm::vec3(0.24f, 0.0f, 0.16f));
+
+	snowLayers.Init("assets/shaders/snow_layers.vert", "assets/shaders/snow_layers.frag");
+	SetPrecipitationLOD(precipitationLOD);
+
+	occlusion.Init(OCCLUSION_CENTER, OCCLUSION_HALF_EXTENT, OCCLUSION_BOTTOM, OCCLUSION_TOP, OCCLUSION_RESOLUTION);
+	particleSystem.SetOcclusion(&occlusion);
+}
+
+void SnowScene::SetPrecipitationLOD(bool enabled) {
+	precipitationLOD = enabled;
+	ApplyParticleRange();
+}
+
+void SnowScene::SetBudgetScale(float scale) {
+	if (scale == budgetScale) return;
+	budgetScale = scale;
+	particleSystem.SetBudgetScale(scale);
+	ApplyParticleRange();
+}
+
+//真实粒子的范围：LOD 关闭时覆盖大部分视距；预算下调时一起缩小，雪层随之前移补上远处
+void SnowScene::ApplyParticleRange() {
+	float radius = precipitationLOD ? LOD_NEAR_RADIUS : SNOW_VIEW_DISTANCE * WRAP_RADIUS_RATIO;
+	radius *= MIN_RANGE_RATIO + (1.0f - MIN_RANGE_RATIO) * budgetScale;
+	particleSystem.SetWrapVolume(true, radius);
+	snowLayers.SetRange(radius, SNOW_VIEW_DISTANCE);
+}
+
+bool SnowScene::IsPrecipitationLOD() const {
+	return precipitationLOD;
+}
+
+PrecipitationOcclusion& SnowScene::GetOcclusion() {
+	return occlusion;
 }
 
-void SnowScene::Update(float deltaTime) {
+void SnowScene::Update(float deltaTime, const Camera& camera) {
 	//camera更新
 	//camera.Update(deltaTime);
+	//雪花环绕体积跟随相机
+	particleSystem.SetViewerPosition(camera.Position);
 	//粒子更新
 	particleSystem.Update(deltaTime, smallSnow);
+	//远景雪层滚动
+	if (precipitationLOD && particleSystem.IsActive())
+		snowLayers.Update(deltaTime, particleSystem.GetWind(), camera.Right);
 }
 
 void SnowScene::Render(Camera camera) {
@@ -25,10 +80,13 @@ void SnowScene::Render(Camera camera) {
 		glm::radians(camera.Zoom),
 		1280.0f / 720.0f,
 		0.1f,
-		100.0f
+		SNOW_VIEW_DISTANCE
 	);
-	//渲染粒子系统
-	particleSystem.Render(view, projection);
+	//先画远景雪层 (由远到近)，再画近处的真实粒子
+	if (precipitationLOD && particleSystem.IsActive())
+		snowLayers.Render(view, projection, camera.Position, particleSystem.GetSpawnRate());
+	//渲染粒子系统 (投影与场景共用 Camera 块，远平面与场景深度一致)
+	particleSystem.Render(view);
 }
 
 void SnowScene::setSmallSnow(bool set) {
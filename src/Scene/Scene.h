@@ -1,17 +1,35 @@
 ﻿#include "ParticleSystem.h"
+#include "SnowLayers.h"
+#include "PrecipitationOcclusion.h"
 #include "Core/Camera.h"
 
 // 下雪场景类
 class SnowScene {
 public:
 	void Init(const char* vertPath, const char* fragPath, const char* texturePath);
-	void Update(float deltaTime);
+	void Update(float deltaTime, const Camera& camera);
 	void Render(Camera camera);
 	void setSmallSnow(bool set);
 	ParticleSystem& GetParticleSystem();
 
+	// 降雪 LOD：开启时只在相机附近模拟真实粒子，远处用 SnowLayers 的全屏雪层代替
+	void SetPrecipitationLOD(bool enabled);
+	bool IsPrecipitationLOD() const;
+
+	// 帧时间调节器给出的预算系数 (0~1)：缩放雪花的生成速率、粒子数上限和真实粒子的范围 (更远处交给雪层)
+	void SetBudgetScale(float scale);
+
+	// 降雪遮挡高度图：IsDirty() 时由外部用 GetViewProjection() 把场景画进去 (见 main.cpp)
+	PrecipitationOcclusion& GetOcclusion();
+
 private:
+	void ApplyParticleRange();
+
 	ParticleSystem particleSystem;
+	SnowLayers snowLayers;
+	PrecipitationOcclusion occlusion;
 	bool smallSnow = false;
+	bool precipitationLOD = true;
+	float budgetScale = 1.0f;
 	//Camera camera;
 };
\ No newline at end of file
@@ -0,0 +1,16 @@
+﻿#include "SceneObject.h"
+#include "Renderer/Model.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+glm::mat4 SceneObject::GetModelMatrix() const {
+	glm::mat4 matrix = glm::mat4(1.0f);
+	matrix = glm::translate(matrix, position);
+	matrix = glm::rotate(matrix, glm::radians(rotationAngle), rotationAxis);
+	matrix = glm::scale(matrix, scale);
+	return matrix;
+}
+
+AABB SceneObject::GetWorldBounds() const {
+	return TransformAABB(model->bounds, GetModelMatrix());
+}
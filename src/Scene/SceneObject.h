@@ -0,0 +1,23 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include "Core/Collision.h"
+
+class Model;
+
+// 定义一个结构体，用来管理场景里的每一个物体
+struct SceneObject {
+	Model* model;       // 模型指针
+	glm::vec3 position; // 位置
+	glm::vec3 scale;    // 缩放
+	float rotationAngle; // 旋转角度 (度)
+	glm::vec3 rotationAxis; // 旋转轴
+
+	SceneObject(Model* m, glm::vec3 pos, glm::vec3 s, float rot, glm::vec3 axis)
+		: model(m), position(pos), scale(s), rotationAngle(rot), rotationAxis(axis) {
+	}
+
+	// 模型矩阵：平移 * 旋转 * 缩放
+	glm::mat4 GetModelMatrix() const;
+	// 世界空间包围盒：模型包围盒变换到世界空间后的 AABB
+	AABB GetWorldBounds() const;
+};
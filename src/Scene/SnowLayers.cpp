@@ -0,0 +1,178 @@
+﻿#include "SnowLayers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//雪层中雪花的下落速度 (米/秒)
+static const float LAYER_FALL_SPEED = 3.0f;
+//雪层网格大小与雪花半径 (米)
+static const float LAYER_CELL_SIZE = 1.5f;
+static const float LAYER_FLAKE_RADIUS = 0.05f;
+//雪层整体不透明度，比近处粒子略淡一点，体现距离感
+static const float LAYER_OPACITY = 0.8f;
+//达到该生成速率 (大雪) 时雪层密度最大
+static const float LAYER_REFERENCE_RATE = 1600.0f;
+static const float LAYER_MAX_DENSITY = 0.6f;
+//雪层的高度范围
+static const float LAYER_GROUND_HEIGHT = -1.0f;
+static const float LAYER_TOP_ABOVE_CAMERA = 40.0f;
+
+static float quad[] = {
+	-1.0f, -1.0f,
+	 1.0f, -1.0f,
+	 1.0f,  1.0f,
+	-1.0f,  1.0f
+};
+
+unsigned int SnowLayers::LoadShader(const char* vertPath, const char* fragPath) {
+	auto loadFile = [](const char* path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			std::cout << "Failed to open file: " << path << std::endl;
+			return std::string();
+		}
+		// 跳过 UTF-8 BOM
+		unsigned char bom[3] = { 0 };
+		file.read(reinterpret_cast<char*>(bom), 3);
+		if (!(bom[0] == 0xEF && bom[1] == 0xBB && bom[2] == 0xBF)) {
+			file.seekg(0);
+		}
+		std::stringstream ss;
+		ss << file.rdbuf();
+		return ss.str();
+		};
+
+	std::string vertCode = loadFile(vertPath);
+	std::string fragCode = loadFile(fragPath);
+	if (vertCode.empty() || fragCode.empty()) return 0;
+
+	const char* vSrc = vertCode.c_str();
+	const char* fSrc = fragCode.c_str();
+
+	int success;
+	char infoLog[512];
+
+	unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vs, 1, &vSrc, nullptr);
+	glCompileShader(vs);
+	glGetShaderiv(vs, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(vs, 512, NULL, infoLog);
+		std::cout << "ERROR::SNOW_LAYERS_VERT::COMPILATION_FAILED\n" << infoLog << std::endl;
+	}
+
+	unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fs, 1, &fSrc, nullptr);
+	glCompileShader(fs);
+	glGetShaderiv(fs, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(fs, 512, NULL, infoLog);
+		std::cout << "ERROR::SNOW_LAYERS_FRAG::COMPILATION_FAILED\n" << infoLog << std::endl;
+	}
+
+	unsigned int prog = glCreateProgram();
+	glAttachShader(prog, vs);
+	glAttachShader(prog, fs);
+	glLinkProgram(prog);
+	glGetProgramiv(prog, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(prog, 512, NULL, infoLog);
+		std::cout << "ERROR::SNOW_LAYERS_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	}
+
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+	return prog;
+}
+
+void SnowLayers::Init(const char* vertPath, const char* fragPath) {
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glBindVertexArray(0);
+
+	shader = LoadShader(vertPath, fragPath);
+	locProjection = glGetUniformLocation(shader, "projection");
+	locInvViewProj = glGetUniformLocation(shader, "invViewProj");
+	locCameraPos = glGetUniformLocation(shader, "cameraPos");
+	locLayerDistance = glGetUniformLocation(shader, "layerDistance");
+	locLayerSeed = glGetUniformLocation(shader, "layerSeed");
+	locScroll = glGetUniformLocation(shader, "scroll");
+	locCellSize = glGetUniformLocation(shader, "cellSize");
+	locDensity = glGetUniformLocation(shader, "density");
+	locFlakeRadius = glGetUniformLocation(shader, "flakeRadius");
+	locPixelSize = glGetUniformLocation(shader, "pixelSize");
+	locGroundHeight = glGetUniformLocation(shader, "groundHeight");
+	locTopHeight = glGetUniformLocation(shader, "topHeight");
+	locTime = glGetUniformLocation(shader, "time");
+	locOpacity = glGetUniformLocation(shader, "opacity");
+}
+
+// 各层距离按等比数列分布在 (nearRadius, farDistance] 之间，近处更密
+void SnowLayers::SetRange(float nearRadius, float farDistance) {
+	float first = nearRadius * 1.25f;
+	float last = std::max(first, farDistance * 0.9f);
+	float ratio = std::pow(last / first, 1.0f / (LAYER_COUNT - 1));
+	for (int i = 0; i < LAYER_COUNT; ++i)
+		layerDistance[i] = first * std::pow(ratio, (float)i);
+}
+
+void SnowLayers::Update(float deltaTime, const glm::vec3& wind, const glm::vec3& cameraRight) {
+	time += deltaTime;
+	// 在 CPU 上累加滚动偏移：相机转动只改变滚动速度，不会让雪层跳变
+	glm::vec2 right = glm::vec2(cameraRight.x, cameraRight.z);
+	scroll.x -= glm::dot(glm::vec2(wind.x, wind.z), right) * deltaTime;
+	scroll.y += LAYER_FALL_SPEED * deltaTime;
+}
+
+void SnowLayers::Render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float spawnRate) {
+	if (shader == 0) return;
+	float density = LAYER_MAX_DENSITY * std::min(spawnRate / LAYER_REFERENCE_RATE, 1.0f);
+	if (density <= 0.0f) return;
+
+	// 该距离上一个像素的世界尺寸 = 距离 * 2tan(fov/2) / 视口高度
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	float pixelPerDistance = 2.0f / (projection[1][1] * (float)std::max(viewport[3], 1));
+
+	glEnable(GL_BLEND);
+	// alpha 通道按 "over" 累积覆盖率，画到离屏透明目标时颜色即为预乘 alpha (见 LowResParticlePass)
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+
+	glUseProgram(shader);
+	glm::mat4 invViewProj = glm::inverse(projection * view);
+	glUniformMatrix4fv(locProjection, 1, GL_FALSE, &projection[0][0]);
+	glUniformMatrix4fv(locInvViewProj, 1, GL_FALSE, &invViewProj[0][0]);
+	glUniform3f(locCameraPos, cameraPos.x, cameraPos.y, cameraPos.z);
+	glUniform2f(locScroll, scroll.x, scroll.y);
+	glUniform1f(locCellSize, LAYER_CELL_SIZE);
+	glUniform1f(locDensity, density);
+	glUniform1f(locFlakeRadius, LAYER_FLAKE_RADIUS);
+	glUniform1f(locGroundHeight, LAYER_GROUND_HEIGHT);
+	glUniform1f(locTopHeight, cameraPos.y + LAYER_TOP_ABOVE_CAMERA);
+	glUniform1f(locTime, time);
+	glUniform1f(locOpacity, LAYER_OPACITY);
+
+	glBindVertexArray(VAO);
+	// 由远到近绘制，保证半透明混合顺序正确
+	for (int i = LAYER_COUNT - 1; i >= 0; --i) {
+		glUniform1f(locLayerDistance, layerDistance[i]);
+		glUniform1ui(locLayerSeed, (unsigned int)(i + 1) * 2654435761u);
+		glUniform1f(locPixelSize, layerDistance[i] * pixelPerDistance);
+		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	}
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDisable(GL_BLEND);
+}
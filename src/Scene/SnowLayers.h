@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+/*
+SnowLayers: 降雪 LOD 的远景部分
+
+近处 (nearRadius 以内) 仍然使用 ParticleSystem 的真实粒子，更远处的雪用几层全屏雪层代替：
+	- 每一层是一个全屏四边形，深度放在该层距离上，开启深度测试，被场景物体自然遮挡
+	- 片段着色器把该层看成以相机为轴的圆柱面，在上面按网格程序化生成雪花 (snow_layers.frag)
+	- 雪层随风 (沿相机右方向的分量) 与固定下落速度滚动，密度由粒子系统的生成速率决定
+
+无论视距多远、雪下得多大，远景的开销都固定为 LAYER_COUNT 次全屏绘制。
+*/
+class SnowLayers {
+public:
+	static const int LAYER_COUNT = 4;
+
+	void Init(const char* vertPath, const char* fragPath);
+	// nearRadius: 真实粒子的范围; farDistance: 最远一层的距离上限 (视距)
+	void SetRange(float nearRadius, float farDistance);
+	void Update(float deltaTime, const glm::vec3& wind, const glm::vec3& cameraRight);
+	// spawnRate: 粒子系统当前的生成速率，用来换算雪层密度
+	void Render(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, float spawnRate);
+
+private:
+	unsigned int LoadShader(const char* vertPath, const char* fragPath);
+
+	unsigned int VAO = 0, VBO = 0;
+	unsigned int shader = 0;
+
+	float layerDistance[LAYER_COUNT] = { 0.0f };
+	glm::vec2 scroll = glm::vec2(0.0f);	// 所有层共用的滚动偏移 (米)
+	float time = 0.0f;
+
+	GLint locProjection = -1;
+	GLint locInvViewProj = -1;
+	GLint locCameraPos = -1;
+	GLint locLayerDistance = -1;
+	GLint locLayerSeed = -1;
+	GLint locScroll = -1;
+	GLint locCellSize = -1;
+	GLint locDensity = -1;
+	GLint locFlakeRadius = -1;
+	GLint locPixelSize = -1;
+	GLint locGroundHeight = -1;
+	GLint locTopHeight = -1;
+	GLint locTime = -1;
+	GLint locOpacity = -1;
+};
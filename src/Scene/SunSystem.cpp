@@ -1,4 +1,5 @@
 ﻿#include "SunSystem.h"
+#include "../Renderer/FrameUniforms.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -149,13 +150,9 @@ void SunSystem::Init(const char* vertPath, const char* fragPath) {
     // ---------------------------------------------------------
     shader = LoadShader(vertPath, fragPath);
     locModel = glGetUniformLocation(shader, "model");
-    locView = glGetUniformLocation(shader, "view");
-    locProj = glGetUniformLocation(shader, "projection");
-    locSunColor = glGetUniformLocation(shader, "sunColor");
 
-    // 【新增】获取强度和相机位置的 Uniform
-    glUseProgram(shader);
-    glUniform1f(glGetUniformLocation(shader, "sunIntensity"), 1.0f); // 给个默认值防止为0
+    // 相机位置、太阳颜色与强度都来自共享的 Camera / Sun 块
+    FrameUniforms::BindBlocks(shader);
 
     glBindVertexArray(0);
 }
@@ -241,23 +238,11 @@ void SunSystem::Update(float deltaTime, float timeSlider) {
     }
 }
 
-void SunSystem::Render(Camera& camera) {
+void SunSystem::Render() {
     if (direction.y < -0.2f) return;
 
     glUseProgram(shader);
 
-    // 设置变换矩阵 (保持原样)
-    glm::mat4 view = camera.GetViewMatrix();
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 1280.0f / 720.0f, 0.1f, 300.0f);
-
-    if (locView != -1) glUniformMatrix4fv(locView, 1, GL_FALSE, &view[0][0]);
-    if (locProj != -1) glUniformMatrix4fv(locProj, 1, GL_FALSE, &projection[0][0]);
-    if (locSunColor != -1) glUniform3fv(locSunColor, 1, &color[0]);
-
-    // 必须传递这些参数，否则太阳在 Shader 里计算结果为 0 (黑色)
-    glUniform1f(glGetUniformLocation(shader, "sunIntensity"), intensity);
-    glUniform3fv(glGetUniformLocation(shader, "viewPos"), 1, &camera.Position[0]);
-
     glm::mat4 model(1.0f);
     model = glm::translate(model, worldPos);
     model = glm::scale(model, glm::vec3(6.0f));
@@ -22,7 +22,8 @@ public:
     // --- 系统接口 ---
     void Init(const char* vertPath, const char* fragPath);
     void Update(float deltaTime, float timeSlider);
-    void Render(Camera& camera);
+    // 相机矩阵、太阳颜色与强度取自每帧共享的 uniform 块 (FrameUniforms)，调用前需要已经 Upload
+    void Render();
     
 private:
     unsigned int LoadShader(const char* vertPath, const char* fragPath);
@@ -34,10 +35,7 @@ private:
     unsigned int EBO = 0;        // 新增：索引缓冲对象
 
     // Uniform 缓存
-    GLint locView = -1;
-    GLint locProj = -1;
     GLint locModel = -1;
-    GLint locSunColor = -1;
 };
 
 #endif
\ No newline at end of file